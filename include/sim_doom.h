@@ -12,6 +12,22 @@
 // SIM Card constraints
 #define SIM_RAM_SIZE        8192    // 8KB total RAM
 
+// RAM of the card host builds emulate (sim_set_card_ram() changes it)
+#ifndef SIM_CARD_RAM
+#if defined(MEMORY_CONFIG) && MEMORY_CONFIG == 3
+#define SIM_CARD_RAM        65536
+#elif defined(MEMORY_CONFIG) && MEMORY_CONFIG == 2
+#define SIM_CARD_RAM        32768
+#else
+#define SIM_CARD_RAM        SIM_RAM_SIZE
+#endif
+#endif
+
+// Stack depth the applet allows for (APDU buffers are counted separately)
+#ifndef SIM_APP_STACK
+#define SIM_APP_STACK       1024
+#endif
+
 // Screen dimensions (text mode)
 #define SCREEN_WIDTH        40
 #define SCREEN_HEIGHT       25
@@ -24,19 +40,149 @@
 #define INS_GET_SCREEN      0x04
 #define INS_GET_STATUS      0x05
 #define INS_RESET_GAME      0x06
+#define INS_GET_STATE_HASH  0x07
+#define INS_SAVE_STATE      0x08
+#define INS_LOAD_STATE      0x09
+#define INS_GET_STATS       0x0A
+#define INS_GET_RESPONSE    0xC0    // Also accepted with CLA 00
 
 // APDU Status words
 #define SW_SUCCESS          0x9000
+#define SW_MORE_DATA        0x6100  // Low byte = bytes still available
+#define SW_WRONG_DATA       0x6A80
+#define SW_WRONG_P1P2       0x6B00
+#define SW_CONDITIONS       0x6985
 #define SW_WRONG_LENGTH     0x6700
 #define SW_WRONG_CLASS      0x6E00
 #define SW_WRONG_INS        0x6D00
 #define SW_ERROR            0x6F00
 
-// Memory management (for SIM environment)
+// Memory management (for SIM environment). The heap is split into three
+// bump-allocated arenas, one per lifetime; freeing is a rewind, never a
+// per-block free, and nothing is zeroed on release.
+typedef enum {
+    ARENA_PERSISTENT,       // Whole session
+    ARENA_LEVEL,            // Released when a new level starts building
+    ARENA_TRANSIENT,        // Released at the end of every APDU
+    ARENA_COUNT
+} SimArena;
+
+// Region sizes (override with -D). sim_memory_init() trims the level arena
+// to what the card actually has left; the adaptive profile reserves room
+// for its pools at their ceilings (checked in text_doom_game.c) and lets
+// that trim decide. Profiles without save states have no use for the
+// persistent and transient arenas and give them nothing.
+//
+// The persistent arena holds LOAD_STATE's staging buffer, which must fit
+// the profile's largest snapshot (checked in sim_game_main.c).
+#ifndef ARENA_PERSISTENT_SIZE
+#if defined(MEMORY_CONFIG) && MEMORY_CONFIG == 2
+#ifdef LARGE_WORLD
+#define ARENA_PERSISTENT_SIZE   384
+#else
+#define ARENA_PERSISTENT_SIZE   256
+#endif
+#elif defined(MEMORY_CONFIG) && MEMORY_CONFIG == 3
+#ifdef LARGE_WORLD
+#define ARENA_PERSISTENT_SIZE   768
+#else
+#define ARENA_PERSISTENT_SIZE   512
+#endif
+#elif defined(MEMORY_CONFIG) && MEMORY_CONFIG == 4
+#ifdef LARGE_WORLD
+#define ARENA_PERSISTENT_SIZE   1280
+#else
+#define ARENA_PERSISTENT_SIZE   768
+#endif
+#else
+#define ARENA_PERSISTENT_SIZE   0
+#endif
+#endif
+#ifndef ARENA_LEVEL_SIZE
+#if defined(MEMORY_CONFIG) && MEMORY_CONFIG == 4
+#define ARENA_LEVEL_SIZE        2048
+#else
+#define ARENA_LEVEL_SIZE        512
+#endif
+#endif
+
+// LOAD_STATE checks a snapshot in a scratch GameState taken from the
+// transient arena, so save-state profiles size it to their GameState
+// (save_state.c checks); large worlds widen every coordinate.
+#ifndef ARENA_TRANSIENT_SIZE
+#if defined(MEMORY_CONFIG) && MEMORY_CONFIG == 3
+#ifdef LARGE_WORLD
+#define ARENA_TRANSIENT_SIZE    1536
+#else
+#define ARENA_TRANSIENT_SIZE    1024
+#endif
+#elif defined(MEMORY_CONFIG) && MEMORY_CONFIG == 2
+#ifdef LARGE_WORLD
+#define ARENA_TRANSIENT_SIZE    1024
+#else
+#define ARENA_TRANSIENT_SIZE    512
+#endif
+#elif defined(MEMORY_CONFIG) && MEMORY_CONFIG == 4
+#ifdef LARGE_WORLD
+#define ARENA_TRANSIENT_SIZE    640
+#else
+#define ARENA_TRANSIENT_SIZE    384
+#endif
+#else
+#define ARENA_TRANSIENT_SIZE    0
+#endif
+#endif
+
+typedef uint16_t ArenaMark;
+
+typedef struct {
+    uint16_t size;
+    uint16_t used;
+    uint16_t high_water;    // Most ever in use since the last stats reset
+} ArenaStats;
+
+void* sim_arena_alloc(SimArena arena, uint16_t size);
+ArenaMark sim_arena_mark(SimArena arena);
+void sim_arena_rewind(SimArena arena, ArenaMark mark);
+void sim_arena_reset(SimArena arena);
+const ArenaStats* sim_arena_get_stats(SimArena arena);
+void sim_arena_reset_stats(SimArena arena);
+
 void* sim_malloc(uint16_t size);
 void sim_heap_reset(void);
 uint16_t sim_get_free_memory(void);
-void sim_memory_init(void);
+void sim_memory_init(uint32_t fixed_ram);
+uint32_t sim_card_ram(void);
+void sim_set_card_ram(uint32_t bytes);
+
+// Emulated NVM (EEPROM/flash) behind a RAM write-back cache
+#ifndef NVM_SIZE
+#define NVM_SIZE            65536   // NVM image size in bytes
+#endif
+#define NVM_PAGE_SIZE       64      // Programming granularity
+#define NVM_CACHE_PAGES     4       // Write-back cache slots (RAM cost)
+#define NVM_PROGRAM_US      3000    // Modelled time to program one page
+
+typedef struct {
+    uint32_t page_programs;     // Pages physically programmed
+    uint32_t programs_skipped;  // Dirty pages that turned out unchanged
+    uint32_t bytes_requested;   // Bytes passed to nvm_write
+    uint32_t bytes_programmed;  // Bytes physically programmed
+    uint32_t bytes_read;
+    uint32_t cache_hits;        // Writes that found their page cached
+    uint32_t cache_misses;
+    uint32_t program_us;        // Modelled programming latency
+    uint16_t max_page_wear;     // Most programs of any single page (host)
+} NvmStats;
+
+bool nvm_init(const char* backing_path);
+void nvm_close(void);
+bool nvm_ready(void);
+bool nvm_read(uint32_t addr, void* dst, uint16_t len);
+bool nvm_write(uint32_t addr, const void* src, uint16_t len);
+void nvm_flush(void);
+const NvmStats* nvm_get_stats(void);
+void nvm_reset_stats(void);
 
 // APDU handling
 void handle_apdu(const uint8_t* cmd_buffer, uint16_t cmd_len, 
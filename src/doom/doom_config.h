@@ -10,6 +10,7 @@
 #define MINIMAL   1  // 8KB RAM (basic SIM cards)
 #define STANDARD  2  // 32KB RAM (modern SIM cards)
 #define ENHANCED  3  // 64KB+ RAM (high-end eSIM)
+#define ADAPTIVE  4  // Any card: pools sized to the RAM found at INIT
 
 // Set default if not specified
 #ifndef MEMORY_CONFIG
@@ -57,6 +58,50 @@
     #define ENABLE_PARTICLE_EFFECTS 1
     #define ENABLE_ADVANCED_AI 1
     #define MEMORY_SIZE_STR "64KB+"
+
+#elif MEMORY_CONFIG == ADAPTIVE
+    // Ceilings only: the enemy and bullet pools are carved from the level
+    // arena at each level start, as large as the card's RAM allows. The
+    // ceilings are the widest live masks (64 bits). A card that cannot
+    // fit the minimal profile's pools is refused at INIT_GAME.
+    #define MAX_ENEMIES 64
+    #define MAX_BULLETS 64
+    #define MIN_ENEMIES 3
+    #define MIN_BULLETS 5
+    #define MAX_PICKUPS 15
+    #define MAP_W 60
+    #define MAP_H 40
+    #define SCREEN_W 40
+    #define SCREEN_H 25
+    #define MAX_LEVELS 10
+    #define ENABLE_SAVE_STATES 1
+    #define ENABLE_MULTIPLE_WEAPONS 1
+    #define MEMORY_SIZE_STR "adaptive"
+#endif
+
+#define ADAPTIVE_CAPACITY (MEMORY_CONFIG == ADAPTIVE)
+
+// Large streamed worlds (-DLARGE_WORLD, any profile): 256x256 tiles baked
+// into NVM and paged through a small chunk cache
+#ifdef LARGE_WORLD
+    #undef MAP_W
+    #undef MAP_H
+    #define MAP_W 256
+    #define MAP_H 256
+#endif
+
+// World coordinates are 8.8 fixed point. Card builds stay 16-bit: signed
+// reaches tile 127, unsigned tile 255 (every map has border walls, so
+// positions never go negative). Host builds of large worlds use 32 bits.
+#if MAP_W <= 128 && MAP_H <= 128
+    #define COORD_BITS 16
+    #define COORD_SIGNED 1
+#elif defined(SIM_CARD_TARGET)
+    #define COORD_BITS 16
+    #define COORD_SIGNED 0
+#else
+    #define COORD_BITS 32
+    #define COORD_SIGNED 1
 #endif
 
 // Feature flags
@@ -65,13 +110,15 @@
 #define HAS_PARTICLE_EFFECTS (ENABLE_PARTICLE_EFFECTS == 1)
 #define HAS_ADVANCED_AI (ENABLE_ADVANCED_AI == 1)
 
-// Memory usage estimation
-#if MEMORY_CONFIG == MINIMAL
-    #define ESTIMATED_RAM_USAGE 6144  // ~6KB
-#elif MEMORY_CONFIG == STANDARD
-    #define ESTIMATED_RAM_USAGE 24576 // ~24KB
+// RAM the applet must fit in. Checked at compile time against what the
+// build actually allocates (sim_game_main.c); make memory-report prints
+// where it goes.
+#if MEMORY_CONFIG == STANDARD
+    #define RAM_BUDGET 32768
+#elif MEMORY_CONFIG == ENHANCED
+    #define RAM_BUDGET 65536
 #else
-    #define ESTIMATED_RAM_USAGE 49152 // ~48KB
+    #define RAM_BUDGET 8192   // Minimal, and the smallest card adaptive supports
 #endif
 
 #endif // DOOM_CONFIG_H
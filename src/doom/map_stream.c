@@ -0,0 +1,148 @@
+/*
+ * Map Streaming - worlds larger than RAM, paged in from NVM
+ * At level start the generated layout is baked into NVM as square chunks
+ * of 4-bit tiles. Lookups go through a small LRU cache of chunks in RAM;
+ * the renderer prefetches each band of chunks before drawing it and the
+ * tick prefetches the chunks around the player for collision and AI.
+ *
+ * Pickups and doors are baked in where they were placed; the level's edit
+ * masks still decide whether they are there (see map_tile()).
+ */
+
+#if MAP_STREAMED
+
+#define MAP_CHUNK         8                             // Chunk side in tiles
+#define MAP_CHUNK_SHIFT   3
+#define MAP_CHUNK_BYTES   (MAP_CHUNK * MAP_CHUNK / 2)   // Two tiles per byte
+#define MAP_CHUNKS_X      ((MAP_W + MAP_CHUNK - 1) / MAP_CHUNK)
+#define MAP_CHUNKS_Y      ((MAP_H + MAP_CHUNK - 1) / MAP_CHUNK)
+#define MAP_CHUNK_COUNT   (MAP_CHUNKS_X * MAP_CHUNKS_Y)
+#define MAP_NVM_BASE      0x8000u                       // Upper half of NVM
+
+// Enough for two bands of chunks across the screen
+#define MAP_CACHE_CHUNKS  ((SCREEN_W / MAP_CHUNK + 2) * 2)
+#define MAP_NO_CHUNK      0xFFFF
+
+#if MAP_NVM_BASE + MAP_CHUNK_COUNT * MAP_CHUNK_BYTES > NVM_SIZE
+#error "Streamed map does not fit in NVM"
+#endif
+
+typedef struct {
+    uint32_t lookups;       // map_stream_tile() calls
+    uint32_t hits;          // ...served from the chunk cache
+    uint32_t misses;        // ...that had to read NVM
+    uint32_t prefetched;    // Chunks read ahead of use
+} MapStreamStats;
+
+typedef struct {
+    uint16_t chunk;
+    uint8_t stamp;          // LRU age
+    uint8_t data[MAP_CHUNK_BYTES];
+} MapCacheSlot;
+
+static MapCacheSlot map_cache[MAP_CACHE_CHUNKS];
+static MapCacheSlot* map_last;      // Most recent hit (consecutive tiles share a chunk)
+static uint8_t map_clock = 0;
+static MapStreamStats map_stats;
+
+static void map_cache_clear(void) {
+    for (int i = 0; i < MAP_CACHE_CHUNKS; i++) {
+        map_cache[i].chunk = MAP_NO_CHUNK;
+    }
+    map_last = &map_cache[0];
+}
+
+// Find 'chunk' in the cache, reading it from NVM into the LRU slot if needed
+static MapCacheSlot* map_load_chunk(uint16_t chunk, bool prefetch) {
+    MapCacheSlot* slot = &map_cache[0];
+    
+    for (int i = 0; i < MAP_CACHE_CHUNKS; i++) {
+        if (map_cache[i].chunk == chunk) {
+            slot = &map_cache[i];
+            if (!prefetch) map_stats.hits++;
+            goto found;
+        }
+        if ((uint8_t)(map_clock - map_cache[i].stamp) > (uint8_t)(map_clock - slot->stamp)) {
+            slot = &map_cache[i];
+        }
+    }
+    
+    if (prefetch) map_stats.prefetched++;
+    else map_stats.misses++;
+    slot->chunk = chunk;
+    nvm_read(MAP_NVM_BASE + (uint32_t)chunk * MAP_CHUNK_BYTES, slot->data, MAP_CHUNK_BYTES);
+
+found:
+    slot->stamp = ++map_clock;
+    return slot;
+}
+
+// Raw baked tile at (x, y); the caller bounds-checks
+uint8_t map_stream_tile(int x, int y) {
+    uint16_t chunk = (uint16_t)((y >> MAP_CHUNK_SHIFT) * MAP_CHUNKS_X + (x >> MAP_CHUNK_SHIFT));
+    
+    map_stats.lookups++;
+    if (map_last->chunk == chunk) {
+        map_stats.hits++;
+    } else {
+        map_last = map_load_chunk(chunk, false);
+    }
+    
+    int i = (y & (MAP_CHUNK - 1)) * MAP_CHUNK + (x & (MAP_CHUNK - 1));
+    uint8_t tile = (map_last->data[i >> 1] >> ((i & 1) * 4)) & 0x0F;
+    return tile <= TILE_DOOR ? tile : TILE_WALL;   // Erased NVM reads as wall
+}
+
+// Make sure every chunk touching the tile rectangle [x0,x1] x [y0,y1] is
+// cached. Call before a burst of lookups that would otherwise miss.
+void map_stream_prefetch(int x0, int y0, int x1, int y1) {
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= MAP_W) x1 = MAP_W - 1;
+    if (y1 >= MAP_H) y1 = MAP_H - 1;
+    
+    for (int cy = y0 >> MAP_CHUNK_SHIFT; cy <= y1 >> MAP_CHUNK_SHIFT; cy++) {
+        for (int cx = x0 >> MAP_CHUNK_SHIFT; cx <= x1 >> MAP_CHUNK_SHIFT; cx++) {
+            map_load_chunk((uint16_t)(cy * MAP_CHUNKS_X + cx), true);
+        }
+    }
+}
+
+// Write chunks [first, first + count) of the current level (with no edits
+// applied) into NVM and return the next chunk to bake. Baking chunk 0 drops
+// the cache. Rebaking the same level programs nothing: unchanged pages are
+// skipped by the NVM layer.
+uint16_t map_stream_bake(const GameState* game, uint16_t first, uint16_t count) {
+    uint8_t data[MAP_CHUNK_BYTES];
+    uint16_t end = first + count;
+    
+    if (end > MAP_CHUNK_COUNT) end = MAP_CHUNK_COUNT;
+    if (first == 0) {
+        if (!nvm_ready()) nvm_init(NULL);
+        map_cache_clear();
+    }
+    
+    for (uint16_t chunk = first; chunk < end; chunk++) {
+        int cx = chunk % MAP_CHUNKS_X, cy = chunk / MAP_CHUNKS_X;
+        memset(data, 0, sizeof(data));
+        for (int i = 0; i < MAP_CHUNK * MAP_CHUNK; i++) {
+            int x = cx * MAP_CHUNK + (i & (MAP_CHUNK - 1));
+            int y = cy * MAP_CHUNK + (i >> MAP_CHUNK_SHIFT);
+            uint8_t tile = (x < MAP_W && y < MAP_H) ? level_tile(game, x, y) : TILE_WALL;
+            data[i >> 1] |= (uint8_t)(tile << ((i & 1) * 4));
+        }
+        nvm_write(MAP_NVM_BASE + (uint32_t)chunk * MAP_CHUNK_BYTES, data, MAP_CHUNK_BYTES);
+    }
+    nvm_flush();
+    return end;
+}
+
+const MapStreamStats* map_stream_get_stats(void) {
+    return &map_stats;
+}
+
+void map_stream_reset_stats(void) {
+    memset(&map_stats, 0, sizeof(map_stats));
+}
+
+#endif // MAP_STREAMED
@@ -2,28 +2,68 @@
  * RAD-Doom Enhanced - Text Mode Doom with RAD-inspired rendering
  * For 32KB+ SIM cards with advanced features
  * Inspired by RAD-Doom's clever display techniques
+ *
+ * The first-person view is integer-only: rays walk the tile grid with an
+ * exact DDA and wall heights, sines and cosines come from constant tables,
+ * so the engine runs unchanged on card CPUs without floating point.
  */
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
-// Enhanced configuration for 32KB+ cards
+// Enhanced configuration for 32KB+ cards. Host demos can build bigger
+// views with -DSCREEN_W=... -DSCREEN_H=...
+#ifndef SCREEN_W
 #define SCREEN_W 80      // Double width for better resolution
+#endif
+#ifndef SCREEN_H
 #define SCREEN_H 40      // Taller display
+#endif
 #define MAP_W 64         // Much larger maps
 #define MAP_H 64
 #define MAX_ENEMIES 20
 #define MAX_BULLETS 30
 #define MAX_PICKUPS 10
+#ifdef SIM_CARD_TARGET
 #define MAX_PARTICLES 50
+#else
+#define MAX_PARTICLES 500  // Host builds: 10x the effects
+#endif
 #define MAX_WEAPONS 4
 
 // Color support using ANSI escape codes
 #define COLOR_SUPPORT 1
 #define DITHERING_ENABLED 1
 
+// Host builds can cast the view's columns on several threads
+// (render_rad_walls_parallel); card builds have one core and no threads
+#ifndef RAD_PARALLEL
+#ifdef SIM_CARD_TARGET
+#define RAD_PARALLEL 0
+#else
+#define RAD_PARALLEL 1
+#endif
+#endif
+#if RAD_PARALLEL
+#include <pthread.h>
+#endif
+
+// Host builds dither the view 16 cells at a time with SSE2, or 32 with
+// AVX2 (add -mavx2 to RAD_FLAGS); card builds take the scalar path
+#ifndef RAD_SIMD
+#if !defined(SIM_CARD_TARGET) && (defined(__SSE2__) || defined(__AVX2__))
+#define RAD_SIMD 1
+#else
+#define RAD_SIMD 0
+#endif
+#endif
+#if RAD_SIMD
+#include <immintrin.h>
+#endif
+
 // ANSI color codes
 #define COL_RESET   "\033[0m"
 #define COL_BLACK   "\033[30m"
@@ -37,12 +77,27 @@
 #define COL_BRIGHT  "\033[1m"
 #define COL_DIM     "\033[2m"
 
+// Glyphs the view can show. A view cell packs a glyph index (high 5 bits)
+// and a color (low 3 bits) into one byte; output maps the index to its
+// character here.
+enum {
+    GLYPH_BLANK, GLYPH_HASH, GLYPH_PERCENT, GLYPH_EQUALS, GLYPH_COLON,
+    GLYPH_DASH, GLYPH_BAR, GLYPH_X, GLYPH_E, GLYPH_Z, GLYPH_D, GLYPH_AT,
+    GLYPH_STAR, GLYPH_SMALL_O, GLYPH_ZERO, GLYPH_O, GLYPH_DOT, GLYPH_PLUS,
+    GLYPH_TILDE, GLYPH_CARET, GLYPH_COUNT
+};
+static const char RAD_GLYPHS[GLYPH_COUNT + 1] = " #%=:-|XEZD@*o0O.+~^";
+
+#define RAD_CELL(glyph, color)  ((uint8_t)((glyph) << 3 | (color)))
+#define RAD_CELL_GLYPH(cell)    ((cell) >> 3)
+#define RAD_CELL_COLOR(cell)    ((cell) & 7)
+
 // RAD-Doom inspired dithering patterns
-const char DITHER_PATTERNS[4][4] = {
-    {' ', '.', ':', '+'},  // Light to dark
-    {'#', '%', '@', '#'},  // Wall patterns
-    {'-', '=', '~', '^'},  // Floor patterns
-    {'*', 'o', 'O', '@'}   // Object patterns
+const uint8_t DITHER_PATTERNS[4][4] = {
+    {GLYPH_BLANK, GLYPH_DOT, GLYPH_COLON, GLYPH_PLUS},    // Light to dark
+    {GLYPH_HASH, GLYPH_PERCENT, GLYPH_AT, GLYPH_HASH},    // Wall patterns
+    {GLYPH_DASH, GLYPH_EQUALS, GLYPH_TILDE, GLYPH_CARET}, // Floor patterns
+    {GLYPH_STAR, GLYPH_SMALL_O, GLYPH_O, GLYPH_AT}        // Object patterns
 };
 
 // Enhanced tile types
@@ -56,6 +111,63 @@ const char DITHER_PATTERNS[4][4] = {
 #define TILE_WEAPON     7
 #define TILE_SECRET     8
 
+// Fixed point. Positions are 8.8 (256 units per tile), angles are 1/256ths
+// of a turn and sines and cosines are Q12 (4096 = 1.0).
+#define RAD_FP          256
+#define RAD_ONE         4096
+#define RAD_QUARTER     64
+
+// The view fills the rows above the HUD. Depths are in 1/8 tiles and rays
+// give up beyond RAD_MAX_DEPTH (30 tiles).
+#define RAD_VIEW_H      (SCREEN_H - 10)
+#define RAD_HUD_H       8
+#define RAD_HORIZON     (RAD_VIEW_H / 2)
+#define RAD_DEPTH_SHIFT 3
+#define RAD_MAX_DEPTH   (30 << RAD_DEPTH_SHIFT)
+#define RAD_FAR         255
+
+// Half the 60 degree field of view: tan(30) in Q12, the length of the camera
+// plane that columns are spread across
+#define RAD_PLANE       2365
+
+// Player speed per tick (8.8) and turn per key press (1/256ths of a turn)
+#define RAD_MOVE        64
+#define RAD_TURN        8
+
+// sin() over the first quarter turn in Q12; the rest follows by symmetry
+static const int16_t RAD_SIN[RAD_QUARTER + 1] = {
+       0,  101,  201,  301,  401,  501,  601,  700,  799,  897,  995, 1092, 1189,
+    1285, 1380, 1474, 1567, 1660, 1751, 1842, 1931, 2019, 2106, 2191, 2276, 2359,
+    2440, 2520, 2598, 2675, 2751, 2824, 2896, 2967, 3035, 3102, 3166, 3229, 3290,
+    3349, 3406, 3461, 3513, 3564, 3612, 3659, 3703, 3745, 3784, 3822, 3857, 3889,
+    3920, 3948, 3973, 3996, 4017, 4036, 4052, 4065, 4076, 4085, 4091, 4095, 4096,
+};
+
+// Half a wall's height in rows by depth, for the standard 30-row view:
+// 15 * 8 / (depth + 1). Anything 10 tiles or more away is one row either
+// side of the horizon. rad_wall_half() scales it to other view heights.
+#define RAD_HALF_STEPS  80
+#define RAD_HALF_HORIZON 15
+static const uint8_t RAD_WALL_HALF[RAD_HALF_STEPS] = {
+    120,  60,  40,  30,  24,  20,  17,  15,  13,  12,  11,  10,   9,   9,   8,   8,
+      7,   7,   6,   6,   6,   5,   5,   5,   5,   5,   4,   4,   4,   4,   4,   4,
+      4,   4,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3,   2,
+      2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,
+      2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,
+};
+
+// Wall glyph by depth in whole tiles (depth >> RAD_DEPTH_SHIFT), in 5-tile
+// bands out to RAD_FAR
+static const uint8_t RAD_WALL_SHADE[(RAD_FAR >> RAD_DEPTH_SHIFT) + 1] = {
+    GLYPH_HASH,    GLYPH_HASH,    GLYPH_HASH,    GLYPH_HASH,    GLYPH_HASH,
+    GLYPH_PERCENT, GLYPH_PERCENT, GLYPH_PERCENT, GLYPH_PERCENT, GLYPH_PERCENT,
+    GLYPH_EQUALS,  GLYPH_EQUALS,  GLYPH_EQUALS,  GLYPH_EQUALS,  GLYPH_EQUALS,
+    GLYPH_COLON,   GLYPH_COLON,   GLYPH_COLON,   GLYPH_COLON,   GLYPH_COLON,
+    GLYPH_COLON,   GLYPH_COLON,   GLYPH_COLON,   GLYPH_COLON,   GLYPH_COLON,
+    GLYPH_COLON,   GLYPH_COLON,   GLYPH_COLON,   GLYPH_COLON,   GLYPH_COLON,
+    GLYPH_COLON,   GLYPH_COLON,
+};
+
 // Weapon types
 typedef struct {
     const char* name;
@@ -64,16 +176,82 @@ typedef struct {
     uint8_t fire_rate;
     uint8_t spread;
     char bullet_char;
+    bool hitscan;       // Resolved when fired by a tile DDA (no projectile)
 } Weapon;
 
-// Particle system for effects
+// Particle system for effects, as a structure of arrays. Live particles are
+// packed at the front (slots 0..count-1) and the slots after them are the
+// free list: a spawn takes slot 'count' and a retire moves the last live
+// particle into the hole, both O(1). Card toolchains (SIM_CARD_TARGET) run
+// the update over live slots only; host builds run it over whole 16-byte
+// vectors, with the arrays rounded up so the last vector needs no tail.
+#ifdef SIM_CARD_TARGET
+#define PARTICLE_LANES(n) (n)
+#else
+#define PARTICLE_LANES(n) (((n) + 15) & ~15)
+#endif
+#define PARTICLE_SLOTS PARTICLE_LANES(MAX_PARTICLES)
+
 typedef struct {
-    int16_t x, y;
-    int8_t vx, vy;
-    uint8_t life;
-    uint8_t type;
-    char symbol;
-} Particle;
+    int16_t x[PARTICLE_SLOTS], y[PARTICLE_SLOTS];    // Screen cells
+    int8_t vx[PARTICLE_SLOTS], vy[PARTICLE_SLOTS];
+    uint8_t life[PARTICLE_SLOTS];                    // Ticks left
+    uint8_t depth[PARTICLE_SLOTS];                   // 1/8 tiles, as walls
+    uint8_t glyph[PARTICLE_SLOTS];
+    uint16_t count;
+} ParticlePool;
+
+// Threads split the view into one strip each. Strip edges fall on whole
+// cache lines of column depths (64 columns) when the view is wide enough
+// for every thread to get one, and on 8-column steps otherwise, so that on
+// a narrow view N threads still get N strips
+#define RAD_CACHE_LINE  64
+#define RAD_STRIP_MIN   8
+#define RAD_MAX_STRIPS  (SCREEN_W / RAD_STRIP_MIN)
+#if RAD_PARALLEL && defined(__GNUC__)
+#define RAD_LINE_ALIGNED __attribute__((aligned(RAD_CACHE_LINE)))
+#else
+#define RAD_LINE_ALIGNED
+#endif
+
+// Potentially visible sets. The map is cut into RAD_CLUSTER x RAD_CLUSTER
+// tile clusters; each keeps a bitset of the clusters that can be seen
+// from anywhere inside it. Enemies are filed by cluster too, so the view
+// and hitscan only ever look at the enemies in the player's set, however
+// big the map and the enemy pool.
+//
+// The map is the same every game, so the sets are traced offline: make
+// rad-pvs bakes them into build/rad_pvs.h, and a -DRAD_PVS_BAKED build
+// reads them from there (ROM on a card). Other host builds trace them
+// into the game state as the map is generated (build_rad_pvs), which is
+// tens of milliseconds even on a desktop, so card builds must be baked.
+#define RAD_CLUSTER_SHIFT   3
+#define RAD_CLUSTER         (1 << RAD_CLUSTER_SHIFT)
+#define RAD_CLUSTERS_X      ((MAP_W + RAD_CLUSTER - 1) / RAD_CLUSTER)
+#define RAD_CLUSTERS_Y      ((MAP_H + RAD_CLUSTER - 1) / RAD_CLUSTER)
+#define RAD_CLUSTERS        (RAD_CLUSTERS_X * RAD_CLUSTERS_Y)
+#define RAD_PVS_BYTES       ((RAD_CLUSTERS + 7) / 8)
+#define RAD_CLUSTER_AT(tx, ty) (((ty) >> RAD_CLUSTER_SHIFT) * RAD_CLUSTERS_X + ((tx) >> RAD_CLUSTER_SHIFT))
+#define RAD_PVS_HAS(set, c) (((set)[(c) >> 3] >> ((c) & 7)) & 1)
+
+#ifdef RAD_PVS_BAKED
+#include "rad_pvs.h"                        // rad_pvs[RAD_CLUSTERS][RAD_PVS_BYTES]
+#define RAD_PVS_OF(game, c) (rad_pvs[c])
+#elif defined(SIM_CARD_TARGET)
+#error "Card builds take the baked PVS: make rad-pvs, then build with -DRAD_PVS_BAKED -Ibuild"
+#else
+#define RAD_PVS_OF(game, c) ((game)->pvs[c])
+#endif
+
+// One bit per enemy slot
+#if MAX_ENEMIES <= 32
+typedef uint32_t RadEnemyMask;
+#elif MAX_ENEMIES <= 64
+typedef uint64_t RadEnemyMask;
+#else
+#error "MAX_ENEMIES must fit a 64-bit cluster mask"
+#endif
+#define RAD_ENEMY_BIT(i)    ((RadEnemyMask)1 << (i))
 
 // Enhanced enemy types
 typedef struct {
@@ -101,20 +279,31 @@ typedef struct {
     // World state
     uint8_t map[MAP_H][MAP_W];
     Enemy enemies[MAX_ENEMIES];
-    Particle particles[MAX_PARTICLES];
+    ParticlePool particles;
     
-    // Rendering buffers
-    uint8_t screen[SCREEN_H][SCREEN_W];
-    uint8_t color_buffer[SCREEN_H][SCREEN_W];
-    uint8_t depth_buffer[SCREEN_H][SCREEN_W];
+    // Visibility: each cluster's PVS (unless baked), and the live enemies
+    // standing in it
+#ifndef RAD_PVS_BAKED
+    uint8_t pvs[RAD_CLUSTERS][RAD_PVS_BYTES];
+#endif
+    RadEnemyMask cluster_enemies[RAD_CLUSTERS];
+    
+    // Rendering buffers. The view is stored column by column (the order
+    // rays fill it), one packed glyph+color cell per character; walls are
+    // one per column, so their depth is too. The HUD is plain text.
+    uint8_t cells[SCREEN_W][RAD_VIEW_H] RAD_LINE_ALIGNED;
+    uint8_t column_depth[SCREEN_W] RAD_LINE_ALIGNED;
+    char hud[RAD_HUD_H][SCREEN_W];
     
     // Game state
     uint32_t frame_count;
     uint16_t kills;
     uint16_t secrets_found;
+    uint8_t secrets_total;
     uint8_t level;
     bool game_over;
     bool victory;
+    uint32_t rng;        // Seeded PRNG state (effects included, no rand())
     
     // RAD-inspired features
     uint8_t lighting_mode;
@@ -124,25 +313,233 @@ typedef struct {
 
 // Weapon definitions
 const Weapon weapons[MAX_WEAPONS] = {
-    {"Fist",     10, 0, 10, 0, ' '},
-    {"Pistol",   20, 1, 5,  1, '.'},
-    {"Shotgun",  60, 1, 8,  3, ':'},
-    {"Chaingun", 15, 1, 2,  2, '*'}
+    {"Fist",     10, 0, 10, 0, ' ', true},
+    {"Pistol",   20, 1, 5,  1, '.', true},
+    {"Shotgun",  60, 1, 8,  3, ':', true},
+    {"Chaingun", 15, 1, 2,  2, '*', true}
 };
 
+// Seeded xorshift32 PRNG; deterministic across builds
+uint32_t rad_rand(GameState* game) {
+    uint32_t x = game->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    game->rng = x;
+    return x;
+}
+
+// Forward declarations
+void generate_rad_map(GameState* game);
+void create_room(GameState* game, int x, int y, int w, int h);
+void dig_corridor(GameState* game, int x0, int y0, int x1, int y1);
+void add_doors_and_secrets(GameState* game);
+#ifndef SIM_CARD_TARGET
+void build_rad_pvs(const GameState* game, uint8_t pvs[][RAD_PVS_BYTES]);
+#endif
+void spawn_rad_enemy(GameState* game, uint8_t type);
+void render_rad_walls(GameState* game);
+void render_rad_columns(GameState* game, int x0, int x1);
+#if RAD_PARALLEL
+void render_rad_walls_parallel(GameState* game);
+#endif
+void cast_rad_ray(GameState* game, int32_t rx, int32_t ry, int screen_x);
+void render_rad_enemies(GameState* game);
+void apply_rad_dithering(GameState* game);
+void render_particles(GameState* game);
+void draw_rad_hud(GameState* game);
+void spawn_particle(GameState* game, int16_t x, int16_t y, uint8_t depth, uint8_t type);
+uint8_t select_wall_texture(uint8_t tile, uint8_t depth, int y_offset);
+uint8_t get_tile_color(uint8_t tile);
+
+// Q12 sine of a binary angle (256 to the turn)
+int32_t rad_sin(uint8_t angle) {
+    uint8_t q = angle & (RAD_QUARTER - 1);
+    
+    switch (angle / RAD_QUARTER) {
+        case 0:  return RAD_SIN[q];
+        case 1:  return RAD_SIN[RAD_QUARTER - q];
+        case 2:  return -RAD_SIN[q];
+        default: return -RAD_SIN[RAD_QUARTER - q];
+    }
+}
+
+int32_t rad_cos(uint8_t angle) {
+    return rad_sin((uint8_t)(angle + RAD_QUARTER));
+}
+
+// Half a wall's height in rows at 'depth' (1/8 tiles), for this view
+static int rad_wall_half(int depth) {
+    int half = depth < RAD_HALF_STEPS ? RAD_WALL_HALF[depth] : 1;
+    return half * RAD_HORIZON / RAD_HALF_HORIZON;
+}
+
+// Tiles that stop a ray (pickups lie on the floor and are seen past)
+static bool rad_blocks_sight(uint8_t tile) {
+    return tile == TILE_WALL || tile == TILE_DOOR || tile == TILE_SECRET || tile == TILE_EXIT;
+}
+
+// Walk the ray (rx, ry) (Q12, one unit along the view direction per RAD_ONE)
+// from the player through the tile grid, one tile boundary at a time. The
+// boundary crossed next is the one with the smaller edge / speed, compared
+// as edge_x * ary < edge_y * arx so no division is needed per step.
+// Returns the depth (perpendicular to the view, in 1/8 tiles) of the first
+// tile that blocks sight, or RAD_FAR, and stores that tile in *tile. With
+// 'enemy' non-NULL the walk also stops at the first live enemy's tile and
+// stores its slot there (-1 if none was met).
+uint8_t rad_cast(const GameState* game, int32_t rx, int32_t ry, uint8_t* tile, int* enemy) {
+    int tx = game->player_x / RAD_FP, ty = game->player_y / RAD_FP;
+    int step_x = rx > 0 ? 1 : -1, step_y = ry > 0 ? 1 : -1;
+    int32_t arx = rx < 0 ? -rx : rx, ary = ry < 0 ? -ry : ry;
+    int32_t fx = game->player_x & (RAD_FP - 1), fy = game->player_y & (RAD_FP - 1);
+    int32_t edge_x = rx > 0 ? RAD_FP - fx : fx;
+    int32_t edge_y = ry > 0 ? RAD_FP - fy : fy;
+    int32_t edge, speed;
+    
+    *tile = TILE_EMPTY;
+    if (enemy) *enemy = -1;
+    if (arx == 0 && ary == 0) return RAD_FAR;
+    
+    for (;;) {
+        if (ary == 0 || (arx != 0 && edge_x * ary < edge_y * arx)) {
+            tx += step_x;
+            edge = edge_x;
+            speed = arx;
+            edge_x += RAD_FP;
+        } else {
+            ty += step_y;
+            edge = edge_y;
+            speed = ary;
+            edge_y += RAD_FP;
+        }
+        
+        if (tx < 0 || tx >= MAP_W || ty < 0 || ty >= MAP_H) return RAD_FAR;
+        
+        // Distance along the view direction to the boundary just crossed:
+        // edge / speed tiles, scaled to 1/8 tiles
+        int32_t depth = edge * (RAD_ONE / (RAD_FP >> RAD_DEPTH_SHIFT)) / speed;
+        if (depth >= RAD_MAX_DEPTH) return RAD_FAR;
+        
+        // Only the enemies filed under this tile's cluster can stand on it
+        if (enemy) {
+            RadEnemyMask here = game->cluster_enemies[RAD_CLUSTER_AT(tx, ty)];
+            for (int i = 0; here; i++, here >>= 1) {
+                const Enemy* e = &game->enemies[i];
+                if ((here & 1) && e->x / RAD_FP == tx && e->y / RAD_FP == ty) {
+                    *enemy = i;
+                    return (uint8_t)depth;
+                }
+            }
+        }
+        
+        if (rad_blocks_sight(game->map[ty][tx])) {
+            *tile = game->map[ty][tx];
+            return (uint8_t)depth;
+        }
+    }
+}
+
+#ifndef SIM_CARD_TARGET
+// Tiles that never let sight through. Doors and secret walls do once they
+// open, so visibility sets treat them as open from the start.
+static bool rad_pvs_blocks(uint8_t tile) {
+    return tile == TILE_WALL || tile == TILE_EXIT;
+}
+
+// A view ray stops RAD_MAX_DEPTH out along the view direction: at the edge
+// of the 60-degree field that is 30 / cos 30 < 35 tiles along the ray
+#define RAD_PVS_REACH       35
+// Sample rays per point: 8 * RAD_PVS_SPREAD directions around a square,
+// under half a degree apart
+#define RAD_PVS_SPREAD      64
+
+// Mark in 'seen' every cluster the ray from (px, py) along (rx, ry) enters
+// before it stops: at a tile that always blocks sight (marked too), at the
+// map edge or once it is RAD_PVS_REACH tiles out on either axis. Stepping
+// is rad_cast's.
+static void rad_pvs_trace(const GameState* game, int32_t px, int32_t py,
+                          int32_t rx, int32_t ry, uint8_t* seen) {
+    int ox = px / RAD_FP, oy = py / RAD_FP;
+    int tx = ox, ty = oy;
+    int step_x = rx > 0 ? 1 : -1, step_y = ry > 0 ? 1 : -1;
+    int32_t arx = rx < 0 ? -rx : rx, ary = ry < 0 ? -ry : ry;
+    int32_t edge_x = rx > 0 ? RAD_FP - (px & (RAD_FP - 1)) : (px & (RAD_FP - 1));
+    int32_t edge_y = ry > 0 ? RAD_FP - (py & (RAD_FP - 1)) : (py & (RAD_FP - 1));
+    
+    for (;;) {
+        if (ary == 0 || (arx != 0 && edge_x * ary < edge_y * arx)) {
+            tx += step_x;
+            edge_x += RAD_FP;
+        } else {
+            ty += step_y;
+            edge_y += RAD_FP;
+        }
+        if (tx < 0 || tx >= MAP_W || ty < 0 || ty >= MAP_H) return;
+        if (abs(tx - ox) > RAD_PVS_REACH || abs(ty - oy) > RAD_PVS_REACH) return;
+        
+        int c = RAD_CLUSTER_AT(tx, ty);
+        seen[c >> 3] |= (uint8_t)(1 << (c & 7));
+        if (rad_pvs_blocks(game->map[ty][tx])) return;
+    }
+}
+
+// Build every cluster's PVS into 'pvs': from just inside each corner of
+// every tile the player could stand on, trace rays all the way round and
+// collect the clusters they reach
+void build_rad_pvs(const GameState* game, uint8_t pvs[][RAD_PVS_BYTES]) {
+    static const uint8_t corners[2] = {1, RAD_FP - 2};
+    
+    memset(pvs, 0, RAD_CLUSTERS * RAD_PVS_BYTES);
+    for (int ty = 0; ty < MAP_H; ty++) {
+        for (int tx = 0; tx < MAP_W; tx++) {
+            if (rad_pvs_blocks(game->map[ty][tx])) continue;
+            
+            int c = RAD_CLUSTER_AT(tx, ty);
+            uint8_t* seen = pvs[c];
+            seen[c >> 3] |= (uint8_t)(1 << (c & 7));
+            for (int n = 0; n < 4; n++) {
+                int32_t px = tx * RAD_FP + corners[n & 1], py = ty * RAD_FP + corners[n >> 1];
+                for (int k = -RAD_PVS_SPREAD; k < RAD_PVS_SPREAD; k++) {
+                    rad_pvs_trace(game, px, py, k, -RAD_PVS_SPREAD, seen);
+                    rad_pvs_trace(game, px, py, RAD_PVS_SPREAD, k, seen);
+                    rad_pvs_trace(game, px, py, -k, RAD_PVS_SPREAD, seen);
+                    rad_pvs_trace(game, px, py, -RAD_PVS_SPREAD, -k, seen);
+                }
+            }
+        }
+    }
+}
+#endif
+
+// Live enemies in the clusters the player's cluster can see
+static RadEnemyMask rad_pvs_enemies(const GameState* game) {
+    const uint8_t* pvs = RAD_PVS_OF(game, RAD_CLUSTER_AT(game->player_x / RAD_FP, game->player_y / RAD_FP));
+    RadEnemyMask seen = 0;
+    
+    for (int b = 0; b < RAD_PVS_BYTES; b++) {
+        for (int c = b * 8, bits = pvs[b]; bits; c++, bits >>= 1) {
+            if (bits & 1) seen |= game->cluster_enemies[c];
+        }
+    }
+    return seen;
+}
+
 // Initialize enhanced game
 void init_rad_game(GameState* game) {
     memset(game, 0, sizeof(GameState));
+    game->rng = 0x0001D00Du;
     
-    // Player setup
-    game->player_x = 10 * 256;
-    game->player_y = 10 * 256;
+    // Player setup (centre of tile 10,10, facing east)
+    game->player_x = 10 * RAD_FP + RAD_FP / 2;
+    game->player_y = 10 * RAD_FP + RAD_FP / 2;
+    game->player_angle = 0;
     game->health = 100;
     game->armor = 0;
     game->ammo[0] = 50;  // Bullets
     game->ammo[1] = 0;   // Shells
     game->ammo[2] = 0;   // Cells
     game->current_weapon = 1;
+    game->level = 1;
     
     // Generate enhanced map with rooms and corridors
     generate_rad_map(game);
@@ -155,18 +552,12 @@ void init_rad_game(GameState* game) {
 
 // RAD-inspired map generation
 void generate_rad_map(GameState* game) {
-    // Create border walls
-    for (int y = 0; y < MAP_H; y++) {
-        for (int x = 0; x < MAP_W; x++) {
-            if (x == 0 || x == MAP_W-1 || y == 0 || y == MAP_H-1) {
-                game->map[y][x] = TILE_WALL;
-            } else {
-                game->map[y][x] = TILE_EMPTY;
-            }
-        }
-    }
+    int prev_x = 0, prev_y = 0;
     
-    // Generate rooms
+    // Solid rock; rooms and corridors are dug out of it
+    memset(game->map, TILE_WALL, sizeof(game->map));
+    
+    // Generate rooms, each joined to the one before
     for (int i = 0; i < 8; i++) {
         int room_x = 5 + (i % 4) * 15;
         int room_y = 5 + (i / 4) * 15;
@@ -174,27 +565,34 @@ void generate_rad_map(GameState* game) {
         int room_h = 8 + (i % 2) * 2;
         
         create_room(game, room_x, room_y, room_w, room_h);
+        if (i > 0) {
+            dig_corridor(game, prev_x, prev_y, room_x + room_w / 2, room_y + room_h / 2);
+        }
+        prev_x = room_x + room_w / 2;
+        prev_y = room_y + room_h / 2;
     }
     
     // Add doors and secrets
     add_doors_and_secrets(game);
     
-    // Place exit
+    // Place exit at the end of a corridor from the last room
+    dig_corridor(game, prev_x, prev_y, MAP_W-5, MAP_H-5);
     game->map[MAP_H-5][MAP_W-5] = TILE_EXIT;
+    
+#ifndef RAD_PVS_BAKED
+    build_rad_pvs(game, game->pvs);
+#endif
 }
 
 // RAD-style rendering with dithering and depth
 void render_rad_view(GameState* game) {
-    // Clear buffers
-    memset(game->screen, ' ', sizeof(game->screen));
-    memset(game->color_buffer, 0, sizeof(game->color_buffer));
-    memset(game->depth_buffer, 255, sizeof(game->depth_buffer));
-    
-    // Cast rays for pseudo-3D view (top half of screen)
-    for (int x = 0; x < SCREEN_W; x++) {
-        float angle = (game->player_angle - 30 + (x * 60.0 / SCREEN_W)) * 3.14159 / 180.0;
-        cast_rad_ray(game, angle, x);
-    }
+    // Walls (pseudo-3D view above the HUD), then what stands in front of them
+#if RAD_PARALLEL
+    render_rad_walls_parallel(game);
+#else
+    render_rad_walls(game);
+#endif
+    render_rad_enemies(game);
     
     // Apply dithering and interlacing
     if (DITHERING_ENABLED) {
@@ -208,167 +606,525 @@ void render_rad_view(GameState* game) {
     draw_rad_hud(game);
 }
 
-// Enhanced ray casting with texture variation
-void cast_rad_ray(GameState* game, float angle, int screen_x) {
-    float dx = cos(angle);
-    float dy = sin(angle);
-    float distance = 0;
+// Cast one ray per screen column; each ray writes its whole column, so
+// the view needs no clearing
+void render_rad_walls(GameState* game) {
+    render_rad_columns(game, 0, SCREEN_W);
+}
+
+// Cast columns x0..x1-1. Column rays are spread across the camera plane
+// (perpendicular to the view direction), so their depths are free of
+// fisheye distortion. A column's ray reads the map and writes only that
+// column, so disjoint ranges can be cast at the same time.
+void render_rad_columns(GameState* game, int x0, int x1) {
+    int32_t dir_x = rad_cos(game->player_angle), dir_y = rad_sin(game->player_angle);
+    int32_t plane_x = -dir_y * RAD_PLANE / RAD_ONE, plane_y = dir_x * RAD_PLANE / RAD_ONE;
     
-    while (distance < 30) {
-        int map_x = (game->player_x / 256) + (int)(dx * distance);
-        int map_y = (game->player_y / 256) + (int)(dy * distance);
+    for (int x = x0; x < x1; x++) {
+        // Column x sits at (2x + 1 - W) / W across the plane (-1 left, +1 right)
+        int32_t cam = 2 * x + 1 - SCREEN_W;
+        cast_rad_ray(game, dir_x + plane_x * cam / SCREEN_W,
+                     dir_y + plane_y * cam / SCREEN_W, x);
+    }
+}
+
+#if RAD_PARALLEL
+#define RAD_MAX_THREADS 16
+
+// Persistent render workers. The caller posts a frame by bumping 'frame'
+// and casts strip 0 itself; worker t casts strip t, and the last worker
+// to finish signals 'done'. Each strip goes to the same thread every frame, and each column is cast exactly as
+// the serial path casts it, so the output is byte-identical.
+static struct {
+    pthread_t worker[RAD_MAX_THREADS];
+    pthread_mutex_t lock;
+    pthread_cond_t go, done;
+    GameState* game;
+    unsigned frame, first_frame;
+    int threads, busy;
+    int edge[RAD_MAX_THREADS + 1];                   // Strip t is edge[t]..edge[t + 1]
+    bool quit;
+} rad_pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .go = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+    .threads = 1,
+};
+
+// Cut the view into one strip per thread. With at most SCREEN_W / align
+// threads each step of SCREEN_W / threads columns is at least one align,
+// so rounding the edges to the nearest align leaves no strip empty
+static void rad_pool_split(int threads) {
+    int align = SCREEN_W / threads >= RAD_CACHE_LINE ? RAD_CACHE_LINE : RAD_STRIP_MIN;
+    
+    for (int t = 0; t < threads; t++) {
+        rad_pool.edge[t] = (t * SCREEN_W / threads + align / 2) / align * align;
+    }
+    rad_pool.edge[threads] = SCREEN_W;
+}
+
+static void* rad_worker(void* arg) {
+    int t = (int)(intptr_t)arg;
+    
+    pthread_mutex_lock(&rad_pool.lock);
+    unsigned seen = rad_pool.first_frame;
+    for (;;) {
+        while (rad_pool.frame == seen && !rad_pool.quit) {
+            pthread_cond_wait(&rad_pool.go, &rad_pool.lock);
+        }
+        if (rad_pool.quit) break;
+        seen = rad_pool.frame;
+        GameState* game = rad_pool.game;
+        pthread_mutex_unlock(&rad_pool.lock);
         
-        if (map_x < 0 || map_x >= MAP_W || map_y < 0 || map_y >= MAP_H) break;
+        render_rad_columns(game, rad_pool.edge[t], rad_pool.edge[t + 1]);
         
-        uint8_t tile = game->map[map_y][map_x];
-        if (tile != TILE_EMPTY) {
-            // Calculate wall height based on distance
-            int wall_height = (int)(20.0 / (distance + 0.1));
-            int wall_top = (SCREEN_H / 2) - wall_height;
-            int wall_bottom = (SCREEN_H / 2) + wall_height;
-            
-            // Apply depth shading and texture
-            for (int y = wall_top; y < wall_bottom && y < SCREEN_H - 10; y++) {
-                if (y >= 0) {
-                    uint8_t depth = (uint8_t)(distance * 8);
-                    if (depth < game->depth_buffer[y][screen_x]) {
-                        game->depth_buffer[y][screen_x] = depth;
-                        
-                        // Select character based on distance and texture
-                        char wall_char = select_wall_texture(tile, distance, y - wall_top);
-                        game->screen[y][screen_x] = wall_char;
-                        
-                        // Color based on tile type
-                        game->color_buffer[y][screen_x] = get_tile_color(tile);
-                    }
-                }
-            }
+        pthread_mutex_lock(&rad_pool.lock);
+        if (--rad_pool.busy == 0) pthread_cond_signal(&rad_pool.done);
+    }
+    pthread_mutex_unlock(&rad_pool.lock);
+    return NULL;
+}
+
+// Stop the workers; rendering goes back to the calling thread alone
+void rad_pool_stop(void) {
+    pthread_mutex_lock(&rad_pool.lock);
+    rad_pool.quit = true;
+    pthread_cond_broadcast(&rad_pool.go);
+    pthread_mutex_unlock(&rad_pool.lock);
+    
+    for (int t = 1; t < rad_pool.threads; t++) {
+        pthread_join(rad_pool.worker[t], NULL);
+    }
+    rad_pool.quit = false;
+    rad_pool.threads = 1;
+}
+
+// Render with 'threads' threads (the caller plus threads - 1 workers).
+// Returns how many will be used, each with a strip of its own: no more
+// than there are 8-column strips, and fewer if a worker cannot be started.
+int rad_pool_start(int threads) {
+    rad_pool_stop();
+    if (threads > RAD_MAX_THREADS) threads = RAD_MAX_THREADS;
+    if (threads > RAD_MAX_STRIPS) threads = RAD_MAX_STRIPS;
+    
+    rad_pool.first_frame = rad_pool.frame;
+    for (int t = 1; t < threads; t++) {
+        rad_pool.threads = t + 1;
+        if (pthread_create(&rad_pool.worker[t], NULL, rad_worker, (void*)(intptr_t)t) != 0) {
+            rad_pool.threads = t;
             break;
         }
-        distance += 0.1;
     }
+    rad_pool_split(rad_pool.threads);
+    return rad_pool.threads;
 }
 
-// RAD-inspired dithering for color mixing
-void apply_rad_dithering(GameState* game) {
-    for (int y = 0; y < SCREEN_H - 10; y++) {
-        for (int x = 0; x < SCREEN_W; x++) {
-            // Interlaced dithering pattern
-            if (game->interlace_frame) {
-                if ((x + y) % 2 == 0) {
-                    // Apply dither pattern
-                    int pattern_idx = (game->depth_buffer[y][x] / 64) % 4;
-                    if (game->screen[y][x] == '#') {
-                        game->screen[y][x] = DITHER_PATTERNS[1][pattern_idx];
-                    }
-                }
-            }
+// render_rad_walls, with the strips shared out across the pool
+void render_rad_walls_parallel(GameState* game) {
+    int threads = rad_pool.threads;
+    if (threads <= 1) {
+        render_rad_walls(game);
+        return;
+    }
+    
+    pthread_mutex_lock(&rad_pool.lock);
+    rad_pool.game = game;
+    rad_pool.busy = threads - 1;
+    rad_pool.frame++;
+    pthread_cond_broadcast(&rad_pool.go);
+    pthread_mutex_unlock(&rad_pool.lock);
+    
+    render_rad_columns(game, rad_pool.edge[0], rad_pool.edge[1]);
+    
+    // Join before anything reads the columns
+    pthread_mutex_lock(&rad_pool.lock);
+    while (rad_pool.busy > 0) {
+        pthread_cond_wait(&rad_pool.done, &rad_pool.lock);
+    }
+    pthread_mutex_unlock(&rad_pool.lock);
+}
+#endif
+
+// Enhanced ray casting with texture variation: fill the column top to
+// bottom with blank ceiling, the wall and blank floor
+void cast_rad_ray(GameState* game, int32_t rx, int32_t ry, int screen_x) {
+    uint8_t* column = game->cells[screen_x];
+    uint8_t tile;
+    uint8_t depth = rad_cast(game, rx, ry, &tile, NULL);
+    int y = 0;
+    
+    game->column_depth[screen_x] = depth;
+    if (depth != RAD_FAR) {
+        // Wall height from the depth table
+        int wall_half = rad_wall_half(depth);
+        int wall_top = RAD_HORIZON - wall_half;
+        int wall_bottom = RAD_HORIZON + wall_half;
+        if (wall_bottom > RAD_VIEW_H) wall_bottom = RAD_VIEW_H;
+        
+        // Glyph by distance and texture, color by tile type. Only a wall's
+        // top row can differ from the rest of it, so the column is three
+        // spans and a lintel.
+        uint8_t color = get_tile_color(tile);
+        if (wall_top > 0) {
+            memset(column, RAD_CELL(GLYPH_BLANK, 0), (size_t)wall_top);
+            y = wall_top;
+        }
+        if (y < wall_bottom) {
+            memset(column + y, RAD_CELL(select_wall_texture(tile, depth, 1), color), (size_t)(wall_bottom - y));
+            if (y == wall_top) column[y] = RAD_CELL(select_wall_texture(tile, depth, 0), color);
+            y = wall_bottom;
+        }
+    }
+    if (y < RAD_VIEW_H) memset(column + y, RAD_CELL(GLYPH_BLANK, 0), (size_t)(RAD_VIEW_H - y));
+}
+
+// Enemies as upright blocks. Only those in the player's PVS are looked at;
+// each is projected onto the camera plane with one division, and they are
+// drawn farthest first, each only in the columns where it is nearer than
+// the wall.
+void render_rad_enemies(GameState* game) {
+    int32_t dir_x = rad_cos(game->player_angle), dir_y = rad_sin(game->player_angle);
+    int32_t shift = (int32_t)RAD_ONE * (RAD_FP >> RAD_DEPTH_SHIFT);
+    uint8_t order[MAX_ENEMIES], depths[MAX_ENEMIES];
+    int16_t sides[MAX_ENEMIES];
+    int count = 0;
+    RadEnemyMask visible = rad_pvs_enemies(game);
+    
+    for (int i = 0; visible; i++, visible >>= 1) {
+        const Enemy* e = &game->enemies[i];
+        if (!(visible & 1)) continue;
+        
+        // Offset from the player in 8.8, rotated into view space and
+        // scaled to 1/8 tiles
+        int32_t ex = (int32_t)e->x - game->player_x, ey = (int32_t)e->y - game->player_y;
+        int32_t depth = (ex * dir_x + ey * dir_y) / shift;
+        if (depth <= 0 || depth >= RAD_MAX_DEPTH) continue;
+        
+        // Insert by depth, farthest first
+        int n = count++;
+        for (; n > 0 && depths[n - 1] < depth; n--) {
+            order[n] = order[n - 1];
+            depths[n] = depths[n - 1];
+            sides[n] = sides[n - 1];
         }
+        order[n] = (uint8_t)i;
+        depths[n] = (uint8_t)depth;
+        sides[n] = (int16_t)((ey * dir_x - ex * dir_y) / shift);
+    }
+    
+    for (int n = 0; n < count; n++) {
+        int32_t depth = depths[n];
+        int sx = SCREEN_W / 2 + (int)(sides[n] * (SCREEN_W / 2) * RAD_ONE / (depth * RAD_PLANE));
+        int half = rad_wall_half(depth);
+        int width = half / 2;
+        int top = RAD_HORIZON - half / 2, bottom = RAD_HORIZON + half;
+        uint8_t cell = RAD_CELL(GLYPH_E + game->enemies[order[n]].type % 3, 6);
+        
+        if (top < 0) top = 0;
+        if (bottom > RAD_VIEW_H) bottom = RAD_VIEW_H;
+        for (int x = sx - width; x <= sx + width; x++) {
+            if (x < 0 || x >= SCREEN_W || depth >= game->column_depth[x]) continue;
+            for (int y = top; y < bottom; y++) game->cells[x][y] = cell;
+        }
+    }
+}
+
+// Interlaced dithering swaps a column's '#' cells, on alternate rows, for
+// the wall pattern of its depth band (64/8 = 8 tiles). The swap is an
+// exclusive-or of the glyph bits, zero where the pattern is '#' itself.
+static uint8_t rad_dither_flip(uint8_t depth) {
+    return (uint8_t)((GLYPH_HASH ^ DITHER_PATTERNS[1][depth >> 6]) << 3);
+}
+
+// Rows first, first + 2, ... of one column
+static void rad_dither_column(uint8_t* column, int first, uint8_t flip) {
+    for (int y = first; y < RAD_VIEW_H; y += 2) {
+        if (RAD_CELL_GLYPH(column[y]) == GLYPH_HASH) column[y] ^= flip;
+    }
+}
+
+// Column x starts on row x & 1
+void rad_dither_scalar(GameState* game) {
+    for (int x = 0; x < SCREEN_W; x++) {
+        uint8_t flip = rad_dither_flip(game->column_depth[x]);
+        if (flip) rad_dither_column(game->cells[x], x & 1, flip);
+    }
+}
+
+#if RAD_SIMD
+// Vector width for the view's columns: AVX2 when they hold a whole 32-cell
+// vector, else SSE2, else none (columns too short go scalar)
+#if defined(__AVX2__) && RAD_VIEW_H >= 32
+#define RAD_VEC 32
+#elif RAD_VIEW_H >= 16
+#define RAD_VEC 16
+#else
+#define RAD_VEC 0
+#endif
+
+// rad_dither_column, RAD_VEC cells at a time. A column that is not a whole
+// number of vectors ends with one that overlaps the last: a flipped cell
+// is no longer '#', so going over it again changes nothing.
+#if RAD_VEC == 32
+static void rad_dither_vector(uint8_t* column, int first, uint8_t flip) {
+    const __m256i glyph = _mm256_set1_epi8((char)0xF8);
+    const __m256i hash = _mm256_set1_epi8((char)RAD_CELL(GLYPH_HASH, 0));
+    const __m256i rows[2] = {_mm256_set1_epi16(0x00FF), _mm256_set1_epi16((short)0xFF00)};
+    const __m256i bits = _mm256_set1_epi8((char)flip);
+    
+    for (int y = 0; y < RAD_VIEW_H; y += 32) {
+        int at = y + 32 <= RAD_VIEW_H ? y : RAD_VIEW_H - 32;
+        __m256i v = _mm256_loadu_si256((const __m256i*)(column + at));
+        __m256i hit = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(v, glyph), hash),
+                                       rows[(first ^ at) & 1]);
+        _mm256_storeu_si256((__m256i*)(column + at), _mm256_xor_si256(v, _mm256_and_si256(hit, bits)));
+    }
+}
+#elif RAD_VEC == 16
+static void rad_dither_vector(uint8_t* column, int first, uint8_t flip) {
+    const __m128i glyph = _mm_set1_epi8((char)0xF8);
+    const __m128i hash = _mm_set1_epi8((char)RAD_CELL(GLYPH_HASH, 0));
+    const __m128i rows[2] = {_mm_set1_epi16(0x00FF), _mm_set1_epi16((short)0xFF00)};
+    const __m128i bits = _mm_set1_epi8((char)flip);
+    
+    for (int y = 0; y < RAD_VIEW_H; y += 16) {
+        int at = y + 16 <= RAD_VIEW_H ? y : RAD_VIEW_H - 16;
+        __m128i v = _mm_loadu_si128((const __m128i*)(column + at));
+        __m128i hit = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(v, glyph), hash), rows[(first ^ at) & 1]);
+        _mm_storeu_si128((__m128i*)(column + at), _mm_xor_si128(v, _mm_and_si128(hit, bits)));
+    }
+}
+#else
+#define rad_dither_vector rad_dither_column
+#endif
+
+void rad_dither_simd(GameState* game) {
+    for (int x = 0; x < SCREEN_W; x++) {
+        uint8_t flip = rad_dither_flip(game->column_depth[x]);
+        if (flip) rad_dither_vector(game->cells[x], x & 1, flip);
+    }
+}
+#endif
+
+// RAD-inspired dithering for color mixing, every other frame
+void apply_rad_dithering(GameState* game) {
+    if (game->interlace_frame) {
+#if RAD_SIMD
+        rad_dither_simd(game);
+#else
+        rad_dither_scalar(game);
+#endif
     }
     game->interlace_frame = !game->interlace_frame;
 }
 
-// Particle effects system
+// Particle effects system: move every particle, then retire the spent ones
 void update_particles(GameState* game) {
-    for (int i = 0; i < MAX_PARTICLES; i++) {
-        Particle* p = &game->particles[i];
-        if (p->life > 0) {
-            p->x += p->vx;
-            p->y += p->vy;
-            p->vy += 1;  // Gravity
-            p->life--;
+    ParticlePool* p = &game->particles;
+    int n = PARTICLE_LANES(p->count);
+    
+    // A plain integer loop over the arrays; dead lanes past 'count' are
+    // free-list slots, so what happens to them does not matter. Gravity
+    // only ever pulls down, so a particle below the view, or off a side
+    // and moving away, will not be seen again and is spent early.
+    for (int i = 0; i < n; i++) {
+        p->x[i] += p->vx[i];
+        p->y[i] += p->vy[i];
+        p->vy[i] += 1;  // Gravity
+        bool gone = (p->y[i] >= RAD_VIEW_H && p->vy[i] >= 0) ||
+                    (p->x[i] < 0 && p->vx[i] <= 0) ||
+                    (p->x[i] >= SCREEN_W && p->vx[i] >= 0);
+        p->life[i] = gone ? 0 : p->life[i] - 1;
+    }
+    
+    // Retire spent particles (count is kept in a local: the byte stores
+    // below could otherwise alias it and force a reload per particle)
+    int count = p->count;
+    for (int i = 0; i < count; ) {
+        if (p->life[i] != 0) {
+            i++;
+            continue;
         }
+        int last = --count;
+        p->x[i] = p->x[last];
+        p->y[i] = p->y[last];
+        p->vx[i] = p->vx[last];
+        p->vy[i] = p->vy[last];
+        p->life[i] = p->life[last];
+        p->depth[i] = p->depth[last];
+        p->glyph[i] = p->glyph[last];
     }
+    p->count = (uint16_t)count;
 }
 
-// Spawn particle effect
-void spawn_particle(GameState* game, int16_t x, int16_t y, uint8_t type) {
-    for (int i = 0; i < MAX_PARTICLES; i++) {
-        if (game->particles[i].life == 0) {
-            Particle* p = &game->particles[i];
-            p->x = x;
-            p->y = y;
-            p->type = type;
-            p->life = 20 + (type * 10);
-            
-            switch (type) {
-                case 0:  // Bullet impact
-                    p->vx = (rand() % 5) - 2;
-                    p->vy = -(rand() % 3);
-                    p->symbol = '*';
-                    break;
-                case 1:  // Explosion
-                    p->vx = (rand() % 9) - 4;
-                    p->vy = -(rand() % 5);
-                    p->symbol = "o0O@"[rand() % 4];
-                    break;
-                case 2:  // Blood
-                    p->vx = (rand() % 3) - 1;
-                    p->vy = rand() % 2;
-                    p->symbol = '.';
-                    break;
-            }
+// Spawn particle effect at screen cell (x, y), 'depth' away (it is hidden
+// by walls nearer than that). Dropped if the pool is full.
+void spawn_particle(GameState* game, int16_t x, int16_t y, uint8_t depth, uint8_t type) {
+    ParticlePool* p = &game->particles;
+    if (p->count >= MAX_PARTICLES) return;
+    
+    int i = p->count++;
+    p->x[i] = x;
+    p->y[i] = y;
+    p->depth[i] = depth;
+    p->life[i] = 20 + (type * 10);
+    
+    switch (type) {
+        case 0:  // Bullet impact
+            p->vx[i] = (int)(rad_rand(game) % 5) - 2;
+            p->vy[i] = -(int)(rad_rand(game) % 3);
+            p->glyph[i] = GLYPH_STAR;
+            break;
+        case 1:  // Explosion
+            p->vx[i] = (int)(rad_rand(game) % 9) - 4;
+            p->vy[i] = -(int)(rad_rand(game) % 5);
+            p->glyph[i] = DITHER_PATTERNS[3][rad_rand(game) % 4];
+            break;
+        default:  // Blood
+            p->vx[i] = (int)(rad_rand(game) % 3) - 1;
+            p->vy[i] = (int)(rad_rand(game) % 2);
+            p->glyph[i] = GLYPH_DOT;
             break;
-        }
     }
 }
 
-// Enhanced HUD with color
-void draw_rad_hud(GameState* game) {
-    int hud_y = SCREEN_H - 8;
+// Step onto (x, y) in 8.8 if the tile allows it. Doors open and secret
+// walls give way instead of letting the player through on that step.
+static void rad_step_to(GameState* game, int32_t x, int32_t y) {
+    if (x < 0 || y < 0 || x >= MAP_W * RAD_FP || y >= MAP_H * RAD_FP) return;
     
-    // Clear HUD area
-    for (int y = hud_y; y < SCREEN_H; y++) {
-        for (int x = 0; x < SCREEN_W; x++) {
-            game->screen[y][x] = ' ';
-        }
+    uint8_t* tile = &game->map[y / RAD_FP][x / RAD_FP];
+    switch (*tile) {
+        case TILE_WALL:
+            return;
+        case TILE_DOOR:
+            *tile = TILE_EMPTY;
+            return;
+        case TILE_SECRET:
+            *tile = TILE_EMPTY;
+            game->secrets_found++;
+            return;
+        case TILE_EXIT:
+            game->victory = true;
+            game->game_over = true;
+            return;
+        case TILE_AMMO:
+            game->ammo[0] = game->ammo[0] > 89 ? 99 : game->ammo[0] + 10;
+            *tile = TILE_EMPTY;
+            break;
+        case TILE_HEALTH:
+            game->health = game->health > 75 ? 100 : game->health + 25;
+            *tile = TILE_EMPTY;
+            break;
     }
+    game->player_x = (uint16_t)x;
+    game->player_y = (uint16_t)y;
+}
+
+// Move by (dx, dy) in 8.8, one axis at a time so walls can be slid along
+static void rad_move(GameState* game, int32_t dx, int32_t dy) {
+    rad_step_to(game, game->player_x + dx, game->player_y);
+    rad_step_to(game, game->player_x, game->player_y + dy);
+}
+
+// Fire the current weapon straight ahead; every weapon is hitscan, resolved
+// by the same tile walk the view uses
+static void rad_fire(GameState* game) {
+    const Weapon* w = &weapons[game->current_weapon];
+    uint8_t tile;
+    int slot;
     
-    // Draw status bar frame
-    for (int x = 0; x < SCREEN_W; x++) {
-        game->screen[hud_y][x] = '=';
+    if (game->ammo[0] < w->ammo_use) return;
+    game->ammo[0] -= w->ammo_use;
+    
+    // Effects land just in front of whatever the shot hit
+    uint8_t depth = rad_cast(game, rad_cos(game->player_angle), rad_sin(game->player_angle), &tile, &slot);
+    if (depth > 0) depth--;
+    spawn_particle(game, SCREEN_W / 2, RAD_HORIZON, depth, 0);
+    if (slot < 0) return;
+    
+    Enemy* e = &game->enemies[slot];
+    e->health = e->health > w->damage ? e->health - w->damage : 0;
+    if (e->health == 0) {
+        game->cluster_enemies[RAD_CLUSTER_AT(e->x / RAD_FP, e->y / RAD_FP)] &= ~RAD_ENEMY_BIT(slot);
+        game->kills++;
+        for (int i = 0; i < 4; i++) spawn_particle(game, SCREEN_W / 2, RAD_HORIZON, depth, 2);
+    }
+}
+
+// One fixed tick: apply a key (0 for none), then advance effects
+void step_rad_game(GameState* game, char key) {
+    int32_t dx = rad_cos(game->player_angle) * RAD_MOVE / RAD_ONE;
+    int32_t dy = rad_sin(game->player_angle) * RAD_MOVE / RAD_ONE;
+    
+    switch (key) {
+        case 'w': case 'W': rad_move(game, dx, dy); break;
+        case 's': case 'S': rad_move(game, -dx, -dy); break;
+        case 'a': case 'A': rad_move(game, dy, -dx); break;
+        case 'd': case 'D': rad_move(game, -dy, dx); break;
+        case 'q': case 'Q': game->player_angle -= RAD_TURN; break;
+        case 'e': case 'E': game->player_angle += RAD_TURN; break;
+        case ' ': rad_fire(game); break;
+        case '1': case '2': case '3': case '4':
+            game->current_weapon = (uint8_t)(key - '1');
+            break;
     }
     
+    update_particles(game);
+    game->frame_count++;
+}
+
+// Enhanced HUD
+void draw_rad_hud(GameState* game) {
+    // Clear HUD area
+    memset(game->hud, ' ', sizeof(game->hud));
+    
+    // Draw status bar frame
+    memset(game->hud[0], '=', SCREEN_W);
+    
     // Player status
     char status[SCREEN_W];
     snprintf(status, SCREEN_W, 
         " HP:%03d AP:%03d [%s] Ammo:%02d K:%03d S:%d/%d L:%d ",
         game->health, game->armor,
         weapons[game->current_weapon].name,
-        game->ammo[game->current_weapon > 0 ? 0 : 0],
-        game->kills, game->secrets_found, 5, game->level
+        game->ammo[0],
+        game->kills, game->secrets_found, game->secrets_total, game->level
     );
     
-    for (int i = 0; i < strlen(status) && i < SCREEN_W; i++) {
-        game->screen[hud_y + 2][i] = status[i];
+    for (int i = 0; status[i] && i < SCREEN_W; i++) {
+        game->hud[2][i] = status[i];
     }
     
     // Weapon list
     for (int i = 0; i < MAX_WEAPONS; i++) {
         int x = 5 + i * 15;
         if (x < SCREEN_W - 10) {
-            game->screen[hud_y + 4][x] = '1' + i;
-            game->screen[hud_y + 4][x + 1] = '.';
-            for (int j = 0; j < strlen(weapons[i].name) && x + j + 2 < SCREEN_W; j++) {
-                game->screen[hud_y + 4][x + 2 + j] = weapons[i].name[j];
+            game->hud[4][x] = '1' + i;
+            game->hud[4][x + 1] = '.';
+            for (int j = 0; weapons[i].name[j] && x + j + 2 < SCREEN_W; j++) {
+                game->hud[4][x + 2 + j] = weapons[i].name[j];
             }
             if (i == game->current_weapon) {
-                game->screen[hud_y + 4][x - 1] = '[';
-                game->screen[hud_y + 4][x + 10] = ']';
+                game->hud[4][x - 1] = '[';
+                game->hud[4][x + 10] = ']';
             }
         }
     }
 }
 
-// Output with ANSI colors
+// Output with ANSI colors. The view is transposed here, once, from the
+// column order it was drawn in to the row order the terminal needs.
 void display_rad_screen(const GameState* game) {
     printf("\033[H\033[J");  // Clear screen
     
-    for (int y = 0; y < SCREEN_H; y++) {
+    for (int y = 0; y < RAD_VIEW_H; y++) {
         for (int x = 0; x < SCREEN_W; x++) {
-            if (COLOR_SUPPORT && game->color_buffer[y][x] > 0) {
-                // Apply color based on buffer
-                switch (game->color_buffer[y][x]) {
+            uint8_t cell = game->cells[x][y];
+            if (COLOR_SUPPORT && RAD_CELL_COLOR(cell) > 0) {
+                // Apply color based on the cell
+                switch (RAD_CELL_COLOR(cell)) {
                     case 1: printf(COL_RED); break;
                     case 2: printf(COL_GREEN); break;
                     case 3: printf(COL_BLUE); break;
@@ -379,7 +1135,7 @@ void display_rad_screen(const GameState* game) {
                 }
             }
             
-            printf("%c", game->screen[y][x]);
+            printf("%c", RAD_GLYPHS[RAD_CELL_GLYPH(cell)]);
             
             if (COLOR_SUPPORT) {
                 printf(COL_RESET);
@@ -387,31 +1143,121 @@ void display_rad_screen(const GameState* game) {
         }
         printf("\n");
     }
+    
+    // Gap rows, then the HUD
+    for (int y = RAD_VIEW_H; y < SCREEN_H - RAD_HUD_H; y++) {
+        printf("\n");
+    }
+    for (int y = 0; y < RAD_HUD_H; y++) {
+        printf("%.*s\n", SCREEN_W, game->hud[y]);
+    }
 }
 
-// Helper functions (stubs for now)
+// Helper functions
+
+// Place an enemy on a random open tile away from the player
 void spawn_rad_enemy(GameState* game, uint8_t type) {
-    // Implementation here
+    for (int i = 0; i < MAX_ENEMIES; i++) {
+        Enemy* e = &game->enemies[i];
+        if (e->health > 0) continue;
+        
+        for (int tries = 0; tries < 64; tries++) {
+            int x = 1 + (int)(rad_rand(game) % (MAP_W - 2));
+            int y = 1 + (int)(rad_rand(game) % (MAP_H - 2));
+            int px = game->player_x / RAD_FP, py = game->player_y / RAD_FP;
+            if (game->map[y][x] != TILE_EMPTY) continue;
+            if (abs(x - px) < 5 && abs(y - py) < 5) continue;
+            
+            memset(e, 0, sizeof(*e));
+            e->x = (uint16_t)(x * RAD_FP + RAD_FP / 2);
+            e->y = (uint16_t)(y * RAD_FP + RAD_FP / 2);
+            e->type = type;
+            e->health = 20 + type * 20;
+            game->cluster_enemies[RAD_CLUSTER_AT(x, y)] |= RAD_ENEMY_BIT(i);
+            return;
+        }
+        return;
+    }
 }
 
+// Dig out a room's floor, x..x+w-1 by y..y+h-1
 void create_room(GameState* game, int x, int y, int w, int h) {
-    // Implementation here
+    for (int ty = y; ty < y + h && ty < MAP_H - 1; ty++) {
+        for (int tx = x; tx < x + w && tx < MAP_W - 1; tx++) {
+            game->map[ty][tx] = TILE_EMPTY;
+        }
+    }
 }
 
+// Dig an L-shaped corridor: across along y0, then down or up along x1
+void dig_corridor(GameState* game, int x0, int y0, int x1, int y1) {
+    int sx = x1 > x0 ? 1 : -1, sy = y1 > y0 ? 1 : -1;
+    
+    for (int x = x0; x != x1; x += sx) {
+        if (game->map[y0][x] == TILE_WALL) game->map[y0][x] = TILE_EMPTY;
+    }
+    for (int y = y0; y != y1 + sy; y += sy) {
+        if (game->map[y][x1] == TILE_WALL) game->map[y][x1] = TILE_EMPTY;
+    }
+}
+
+// Doors where corridors enter rooms (an opening with wall either side), a
+// secret wall above every other room with a health pack behind it, and
+// ammo in the odd rooms' corners
 void add_doors_and_secrets(GameState* game) {
-    // Implementation here
+    for (int i = 0; i < 8; i++) {
+        int room_x = 5 + (i % 4) * 15;
+        int room_y = 5 + (i / 4) * 15;
+        int room_w = 8 + (i % 3) * 2;
+        int room_h = 8 + (i % 2) * 2;
+        
+        // The ring of tiles just outside the room
+        for (int y = room_y - 1; y <= room_y + room_h; y++) {
+            for (int x = room_x - 1; x <= room_x + room_w; x++) {
+                bool ring_x = x == room_x - 1 || x == room_x + room_w;
+                bool ring_y = y == room_y - 1 || y == room_y + room_h;
+                if (!ring_x && !ring_y) continue;
+                if (ring_x && ring_y) continue;  // Corners
+                if (game->map[y][x] != TILE_EMPTY) continue;
+                
+                bool walled = ring_y ? game->map[y][x-1] == TILE_WALL && game->map[y][x+1] == TILE_WALL
+                                     : game->map[y-1][x] == TILE_WALL && game->map[y+1][x] == TILE_WALL;
+                if (walled) game->map[y][x] = TILE_DOOR;
+            }
+        }
+        
+        int cx = room_x + room_w / 2;
+        if (i % 2 == 0 && game->map[room_y - 1][cx] == TILE_WALL && game->map[room_y - 2][cx] == TILE_WALL) {
+            game->map[room_y - 1][cx] = TILE_SECRET;
+            game->map[room_y - 2][cx] = TILE_HEALTH;
+            game->secrets_total++;
+        }
+        if (i % 2 == 1) {
+            game->map[room_y][room_x] = TILE_AMMO;
+        }
+    }
 }
 
+// Live particles are drawn over the view in screen cells, except where the
+// column's wall is nearer than they are
 void render_particles(GameState* game) {
-    // Implementation here
+    const ParticlePool* p = &game->particles;
+    
+    for (int i = 0; i < p->count; i++) {
+        int x = p->x[i], y = p->y[i];
+        if (x < 0 || x >= SCREEN_W || y < 0 || y >= RAD_VIEW_H) continue;
+        if (p->depth[i] >= game->column_depth[x]) continue;
+        game->cells[x][y] = RAD_CELL(p->glyph[i], 4);
+    }
 }
 
-char select_wall_texture(uint8_t tile, float distance, int y_offset) {
-    // Select texture based on tile type and distance
-    if (distance < 5) return '#';
-    else if (distance < 10) return '%';
-    else if (distance < 15) return '=';
-    else return ':';
+uint8_t select_wall_texture(uint8_t tile, uint8_t depth, int y_offset) {
+    // Doors (lintel over planks) and the exit keep their own look; walls,
+    // and secret walls which must pass for them, shade with depth in
+    // 5-tile bands
+    if (tile == TILE_DOOR) return y_offset == 0 ? GLYPH_DASH : GLYPH_BAR;
+    if (tile == TILE_EXIT) return GLYPH_X;
+    return RAD_WALL_SHADE[depth >> RAD_DEPTH_SHIFT];
 }
 
 uint8_t get_tile_color(uint8_t tile) {
@@ -419,7 +1265,6 @@ uint8_t get_tile_color(uint8_t tile) {
         case TILE_WALL: return 1;    // Red
         case TILE_EXIT: return 2;    // Green
         case TILE_DOOR: return 4;    // Yellow
-        case TILE_SECRET: return 5;  // Cyan
         default: return 7;           // White
     }
 }
@@ -0,0 +1,410 @@
+/*
+ * Save States - compact GameState snapshots
+ * Serializes everything except derivable data: the level layout is
+ * regenerated from seed and level number, and only the player's edits to
+ * it (pickups taken, doors opened) are stored, so a snapshot is a few
+ * dozen bytes and can be taken every few seconds.
+ *
+ * Snapshot format (version 6, multi-byte fields big-endian):
+ *   'S' 'V' version  length(2)
+ *   level  flags  health  ammo          flags: bit0 game over, bit1 victory,
+ *   player_x(C) player_y(C)                    bits2-3 facing (angle / 90),
+ *                                              bit4 weapon
+ *   frame_count(2) seed(4) rng(4)
+ *   enemy live, idle, coarse and dormant masks, then per live enemy:
+ *                                           x(C) y(C) health<<4|(wait-1)
+ *   bullet live mask, then per live bullet: x(C) y(C) direction
+ *   pickups taken mask, doors open mask
+ *   state hash(4)                           game_state_hash() after loading
+ *
+ * 'wait' is the number of ticks until the enemy next acts (enemy_wait());
+ * idle enemies store 0 there. C is sizeof(coord_t): 2, or 4 on large host
+ * worlds, so no position is ever truncated.
+ *
+ * Snapshots are streamed in windows so they can span several APDUs.
+ */
+
+#if HAS_SAVE_STATES
+
+#define SNAP_MAGIC0       'S'
+#define SNAP_MAGIC1       'V'
+#define SNAP_VERSION      6
+#define SNAP_HEADER_SIZE  5
+
+#define ENEMY_MASK_BYTES  ((MAX_ENEMIES + 7) / 8)
+#define BULLET_MASK_BYTES ((MAX_BULLETS + 7) / 8)
+#define PICKUP_MASK_BYTES ((MAX_PICKUPS + 7) / 8)
+#define DOOR_MASK_BYTES   ((LEVEL_MAX_ROOMS - 1 + 7) / 8)
+#define COORD_BYTES       ((int)sizeof(coord_t))
+
+// Largest possible snapshot (sizes the load staging buffer)
+#define SNAPSHOT_MAX (SNAP_HEADER_SIZE + 4 + 2 * COORD_BYTES + 2 + 4 + 4 + \
+                      ENEMY_MASK_BYTES * 4 + MAX_ENEMIES * (2 * COORD_BYTES + 1) + \
+                      BULLET_MASK_BYTES + MAX_BULLETS * (2 * COORD_BYTES + 1) + \
+                      PICKUP_MASK_BYTES + DOOR_MASK_BYTES + 4)
+
+// LOAD_STATE decodes into a scratch GameState from the transient arena
+STATIC_ASSERT(sizeof(GameState) <= ARENA_TRANSIENT_SIZE, load_scratch_fits_transient_arena);
+
+// Writes the part of the byte stream that falls inside [start, end)
+typedef struct {
+    uint8_t* out;
+    uint16_t start;
+    uint16_t end;
+    uint16_t pos;
+} SnapWriter;
+
+static void snap_put(SnapWriter* w, uint8_t v) {
+    if (w->pos >= w->start && w->pos < w->end) {
+        w->out[w->pos - w->start] = v;
+    }
+    w->pos++;
+}
+
+static void snap_put16(SnapWriter* w, uint16_t v) {
+    snap_put(w, (uint8_t)(v >> 8));
+    snap_put(w, (uint8_t)v);
+}
+
+static void snap_put32(SnapWriter* w, uint32_t v) {
+    snap_put16(w, (uint16_t)(v >> 16));
+    snap_put16(w, (uint16_t)v);
+}
+
+static void snap_put_coord(SnapWriter* w, coord_t c) {
+#if COORD_BITS == 32
+    snap_put32(w, (uint32_t)c);
+#else
+    snap_put16(w, (uint16_t)c);
+#endif
+}
+
+static uint8_t bullet_direction(const BulletPool* b, int i) {
+    if (b->dy[i] < 0) return 0;
+    if (b->dx[i] > 0) return 1;
+    if (b->dy[i] > 0) return 2;
+    return 3;
+}
+
+// Emit the snapshot into 'w'
+static void snap_emit(const GameState* game, SnapWriter* w, uint16_t length) {
+    int i;
+    
+    snap_put(w, SNAP_MAGIC0);
+    snap_put(w, SNAP_MAGIC1);
+    snap_put(w, SNAP_VERSION);
+    snap_put16(w, length);
+    
+    snap_put(w, game->level);
+    snap_put(w, (uint8_t)((game->game_over ? 0x01 : 0) |
+                          (game->victory ? 0x02 : 0) |
+                          ((game->player_angle / 90) << 2) |
+                          (game->weapon << 4)));
+    snap_put(w, game->health);
+    snap_put(w, game->ammo);
+    snap_put_coord(w, game->player_x);
+    snap_put_coord(w, game->player_y);
+    snap_put16(w, game->frame_count);
+    snap_put32(w, game->seed);
+    snap_put32(w, game->rng);
+    
+    for (i = 0; i < ENEMY_MASK_BYTES; i++) {
+        snap_put(w, (uint8_t)(game->enemies.live >> (i * 8)));
+    }
+    for (i = 0; i < ENEMY_MASK_BYTES; i++) {
+        snap_put(w, (uint8_t)((game->enemies.idle & game->enemies.live) >> (i * 8)));
+    }
+    for (i = 0; i < ENEMY_MASK_BYTES; i++) {
+        snap_put(w, (uint8_t)((game->enemies.coarse & game->enemies.live) >> (i * 8)));
+    }
+    for (i = 0; i < ENEMY_MASK_BYTES; i++) {
+        snap_put(w, (uint8_t)((game->enemies.dormant & game->enemies.live) >> (i * 8)));
+    }
+    FOR_EACH_LIVE(EnemyMask, game->enemies.live, i) {
+        snap_put_coord(w, game->enemies.x[i]);
+        snap_put_coord(w, game->enemies.y[i]);
+        uint8_t wait = enemy_wait(game, i);
+        snap_put(w, (uint8_t)((game->enemies.health[i] << 4) | (wait ? (wait - 1) & 0x0F : 0)));
+    }
+    
+    for (i = 0; i < BULLET_MASK_BYTES; i++) {
+        snap_put(w, (uint8_t)(game->bullets.live >> (i * 8)));
+    }
+    FOR_EACH_LIVE(BulletMask, game->bullets.live, i) {
+        snap_put_coord(w, game->bullets.x[i]);
+        snap_put_coord(w, game->bullets.y[i]);
+        snap_put(w, bullet_direction(&game->bullets, i));
+    }
+    
+    // Level edits (the layout itself is regenerated on load)
+    for (i = 0; i < PICKUP_MASK_BYTES; i++) {
+        snap_put(w, (uint8_t)(game->pickups_taken >> (i * 8)));
+    }
+    for (i = 0; i < DOOR_MASK_BYTES; i++) {
+        snap_put(w, (uint8_t)(game->doors_open >> (i * 8)));
+    }
+    
+    snap_put32(w, game_state_hash(game));
+}
+
+// Serialize the window [offset, offset + max_len) of the snapshot into
+// 'out'. Returns the total snapshot length (0 while a level is loading);
+// the number of bytes written is min(max_len, total - offset).
+uint16_t save_state_read(const GameState* game, uint16_t offset,
+                         uint8_t* out, uint16_t max_len) {
+    // A level still being built cannot be described by a snapshot
+    if (LEVEL_LOADING(game)) return 0;
+    
+    SnapWriter sizer = {out, 0, 0, 0};
+    snap_emit(game, &sizer, 0);
+    
+    SnapWriter w = {out, offset, (uint16_t)(offset + max_len), 0};
+    snap_emit(game, &w, sizer.pos);
+    return sizer.pos;
+}
+
+// Reads a snapshot back, bounds-checking every field
+typedef struct {
+    const uint8_t* data;
+    uint16_t len;
+    uint16_t pos;
+    bool ok;
+} SnapReader;
+
+static uint8_t snap_get(SnapReader* r) {
+    if (r->pos >= r->len) {
+        r->ok = false;
+        return 0;
+    }
+    return r->data[r->pos++];
+}
+
+static uint16_t snap_get16(SnapReader* r) {
+    uint16_t hi = snap_get(r);
+    return (uint16_t)((hi << 8) | snap_get(r));
+}
+
+static uint32_t snap_get32(SnapReader* r) {
+    uint32_t hi = snap_get16(r);
+    return (hi << 16) | snap_get16(r);
+}
+
+static coord_t snap_get_coord(SnapReader* r) {
+#if COORD_BITS == 32
+    return (coord_t)snap_get32(r);
+#else
+    return (coord_t)snap_get16(r);
+#endif
+}
+
+static bool snap_position_ok(coord_t x, coord_t y) {
+    int tx = COORD_TILE(x), ty = COORD_TILE(y);
+    return tx >= 0 && ty >= 0 && tx < MAP_W && ty < MAP_H;
+}
+
+// An enemy record. 'wait' comes back in 1..16; idle enemies store none.
+static bool snap_get_enemy(SnapReader* r, coord_t* x, coord_t* y, uint8_t* health, uint8_t* wait) {
+    *x = snap_get_coord(r);
+    *y = snap_get_coord(r);
+    uint8_t packed = snap_get(r);
+    *health = packed >> 4;
+    *wait = (uint8_t)((packed & 0x0F) + 1);
+    return snap_position_ok(*x, *y) && *wait <= ENEMY_WHEEL_SLOTS;
+}
+
+static bool snap_get_bullet(SnapReader* r, coord_t* x, coord_t* y,
+                            coord_delta_t* dx, coord_delta_t* dy) {
+    *x = snap_get_coord(r);
+    *y = snap_get_coord(r);
+    *dx = 0;
+    *dy = 0;
+    switch (snap_get(r)) {
+        case 0: *dy = -BULLET_SPEED * FP_HALF; break;
+        case 1: *dx = BULLET_SPEED * FP_HALF; break;
+        case 2: *dy = BULLET_SPEED * FP_HALF; break;
+        case 3: *dx = -BULLET_SPEED * FP_HALF; break;
+        default: return false;
+    }
+    return true;
+}
+
+// What 's's level will hold once built, worked out from its descriptor
+// without building it: only 's' is written
+static int snap_door_count(GameState* s) {
+#if LEVEL_COMPILED
+    return LEVEL_BLOB(s)[LB_DOORS];
+#else
+    uint32_t rs = level_build_rng(s->seed, s->level);
+    generate_level(s, s->level, &rs);
+    return LEVEL_DOOR_COUNT(&s->layout);
+#endif
+}
+
+#if ADAPTIVE_CAPACITY
+// The enemy slots carve_pools() will find: the level arena less the walls
+// and the sight cache, each rounded up to the arena's 2-byte alignment
+static int snap_enemy_slots(const GameState* s) {
+    int budget = sim_arena_get_stats(ARENA_LEVEL)->size - (int)((sizeof(RoomSight) + 1) & ~1u);
+#if LEVEL_COMPILED
+    const uint8_t* blob = LEVEL_BLOB(s);
+    budget -= (blob[LB_H] * LEVEL_ROW_BYTES(blob[LB_W]) + 1) & ~1;
+#else
+    (void)s;
+#endif
+    return pool_slots(budget);
+}
+#endif
+
+// Decode a snapshot into 's' and check it, leaving the running game
+// alone: the level is not built, and the entity records are checked and
+// hashed as they are read rather than stored (adaptive pools live in the
+// level arena, which only a load that goes ahead may release). Returns
+// the offset of the first enemy record, or 0 if the snapshot is malformed
+// or does not reproduce its hash.
+static uint16_t snap_decode(GameState* s, const uint8_t* data, uint16_t len) {
+    SnapReader r = {data, len, 0, true};
+    int i;
+    
+    memset(s, 0, sizeof(*s));
+    if (snap_get(&r) != SNAP_MAGIC0 || snap_get(&r) != SNAP_MAGIC1 ||
+        snap_get(&r) != SNAP_VERSION || snap_get16(&r) != len) {
+        return 0;
+    }
+    
+    s->level = snap_get(&r);
+    uint8_t flags = snap_get(&r);
+    if (s->level == 0 || s->level > LEVEL_COUNT || (flags & 0xE0)) return 0;
+    s->game_over = (flags & 0x01) != 0;
+    s->victory = (flags & 0x02) != 0;
+    s->player_angle = (uint16_t)(((flags >> 2) & 0x03) * 90);
+    s->weapon = (flags >> 4) & 0x01;
+    s->health = snap_get(&r);
+    s->ammo = snap_get(&r);
+    s->player_x = snap_get_coord(&r);
+    s->player_y = snap_get_coord(&r);
+    s->frame_count = snap_get16(&r);
+    s->seed = snap_get32(&r);
+    s->rng = snap_get32(&r);
+    s->build_stage = LEVEL_STAGE_READY;
+    if (!snap_position_ok(s->player_x, s->player_y)) return 0;
+    
+#if ADAPTIVE_CAPACITY
+    int enemy_cap = snap_enemy_slots(s);
+    int bullet_cap = BULLETS_FOR(enemy_cap);
+#else
+    int enemy_cap = MAX_ENEMIES, bullet_cap = MAX_BULLETS;
+#endif
+    EnemyPool* e = &s->enemies;
+    for (i = 0; i < ENEMY_MASK_BYTES; i++) {
+        e->live |= (EnemyMask)((EnemyMask)snap_get(&r) << (i * 8));
+    }
+    for (i = 0; i < ENEMY_MASK_BYTES; i++) {
+        e->idle |= (EnemyMask)((EnemyMask)snap_get(&r) << (i * 8));
+    }
+    for (i = 0; i < ENEMY_MASK_BYTES; i++) {
+        e->coarse |= (EnemyMask)((EnemyMask)snap_get(&r) << (i * 8));
+    }
+    for (i = 0; i < ENEMY_MASK_BYTES; i++) {
+        e->dormant |= (EnemyMask)((EnemyMask)snap_get(&r) << (i * 8));
+    }
+    if (e->live & (EnemyMask)~SLOTS_ALL(EnemyMask, enemy_cap)) return 0;
+    if ((e->idle | e->coarse | e->dormant) & (EnemyMask)~e->live) return 0;
+    if ((e->coarse & e->dormant) || (e->idle & (e->coarse | e->dormant))) return 0;
+    
+    uint16_t records = r.pos;
+    uint32_t hash = hash_state_head(s);
+    FOR_EACH_LIVE(EnemyMask, e->live, i) {
+        coord_t x, y;
+        uint8_t health, wait;
+        if (!snap_get_enemy(&r, &x, &y, &health, &wait)) return 0;
+        if (e->idle & SLOT_BIT(EnemyMask, i)) wait = 0;
+        hash = hash_enemy(hash, i, x, y, health, wait,
+                          (uint8_t)((e->coarse >> i & 1) | (e->dormant >> i & 1) << 1 | (e->idle >> i & 1) << 2));
+    }
+    
+    BulletPool* b = &s->bullets;
+    for (i = 0; i < BULLET_MASK_BYTES; i++) {
+        b->live |= (BulletMask)((BulletMask)snap_get(&r) << (i * 8));
+    }
+    if (b->live & (BulletMask)~SLOTS_ALL(BulletMask, bullet_cap)) return 0;
+    FOR_EACH_LIVE(BulletMask, b->live, i) {
+        coord_t x, y;
+        coord_delta_t dx, dy;
+        if (!snap_get_bullet(&r, &x, &y, &dx, &dy)) return 0;
+        hash = hash_bullet(hash, i, x, y, dx, dy);
+    }
+    
+    for (i = 0; i < PICKUP_MASK_BYTES; i++) {
+        s->pickups_taken |= (PickupMask)((PickupMask)snap_get(&r) << (i * 8));
+    }
+    for (i = 0; i < DOOR_MASK_BYTES; i++) {
+        s->doors_open |= (DoorMask)((DoorMask)snap_get(&r) << (i * 8));
+    }
+    if (s->pickups_taken & (PickupMask)~SLOTS_ALL(PickupMask, MAX_PICKUPS)) return 0;
+    if (s->doors_open & (DoorMask)~SLOTS_ALL(DoorMask, snap_door_count(s))) return 0;
+    
+    uint32_t stored = snap_get32(&r);
+    return r.ok && r.pos == len && stored == hash_state_tail(hash, s) ? records : 0;
+}
+
+// Restore a complete snapshot into 'game'. The snapshot is checked in a
+// scratch GameState from the transient arena first; if it is malformed,
+// does not fit this card's pools or does not reproduce its hash, false is
+// returned and 'game' is left exactly as it was.
+bool save_state_apply(GameState* game, const uint8_t* data, uint16_t len) {
+    GameState* s = sim_arena_alloc(ARENA_TRANSIENT, sizeof(GameState));
+    uint16_t records = s ? snap_decode(s, data, len) : 0;
+    int i;
+    
+    if (!records) return false;
+    
+    // Regenerate the level from its seed, then layer the saved state on top
+    game->seed = s->seed;
+    init_level(game, s->level);
+    game->game_over = s->game_over;
+    game->victory = s->victory;
+    game->player_angle = s->player_angle;
+    game->weapon = s->weapon;
+    game->health = s->health;
+    game->ammo = s->ammo;
+    game->player_x = s->player_x;
+    game->player_y = s->player_y;
+    game->frame_count = s->frame_count;
+    game->rng = s->rng;
+    
+    // The records passed snap_decode; read them again into the new pools
+    SnapReader r = {data, len, records, true};
+    EnemyPool* e = &game->enemies;
+    BulletPool* b = &game->bullets;
+    if ((s->enemies.live & (EnemyMask)~SLOTS_ALL(EnemyMask, ENEMY_CAP(game))) ||
+        (s->bullets.live & (BulletMask)~SLOTS_ALL(BulletMask, BULLET_CAP(game)))) {
+        return false;
+    }
+    e->live = s->enemies.live;
+    e->idle = s->enemies.idle;
+    e->coarse = s->enemies.coarse;
+    e->dormant = s->enemies.dormant;
+    memset(e->wake, 0, sizeof(e->wake));
+    FOR_EACH_LIVE(EnemyMask, e->live, i) {
+        uint8_t wait;
+        snap_get_enemy(&r, &e->x[i], &e->y[i], &e->health[i], &wait);
+        if (!(e->idle & SLOT_BIT(EnemyMask, i))) enemy_schedule(game, i, wait);
+    }
+    
+    b->live = s->bullets.live;
+    r.pos += BULLET_MASK_BYTES;
+    FOR_EACH_LIVE(BulletMask, b->live, i) {
+        snap_get_bullet(&r, &b->x[i], &b->y[i], &b->dx[i], &b->dy[i]);
+    }
+    
+    game->pickups_taken = s->pickups_taken;
+    game->doors_open = s->doors_open;
+    reset_room_sight();   // Traced with every door shut while the level built
+    
+    // snap_decode checked this hash; it only fails here if the level as
+    // built disagrees with what snap_decode worked out
+    r.pos += PICKUP_MASK_BYTES + DOOR_MASK_BYTES;
+    return game_state_hash(game) == snap_get32(&r);
+}
+
+#endif // HAS_SAVE_STATES
@@ -7,6 +7,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
+#include "sim_doom.h"
 
 // Include configuration header if building with different memory targets
 #ifdef USE_CONFIG_HEADER
@@ -21,9 +22,83 @@
 #define MAP_H 32
 #define MAX_ENEMIES 8
 #define MAX_BULLETS 4
+#define MAX_PICKUPS 3
+#define MAX_LEVELS 3
 #define BULLET_SPEED 2
 #define ENEMY_SPEED 4  // Moves every 4 frames
 #define MEMORY_SIZE_STR "8KB"
+#define COORD_BITS 16
+#define COORD_SIGNED 1
+#define ADAPTIVE_CAPACITY 0
+#define RAM_BUDGET 8192
+#ifdef LARGE_WORLD
+#error "LARGE_WORLD is a doom_config.h option (build with -DUSE_CONFIG_HEADER)"
+#endif
+#endif
+
+// Compile-time check (C99 has no _Static_assert); 'name' says what failed
+#define STATIC_ASSERT(cond, name) typedef char static_assert_##name[(cond) ? 1 : -1]
+
+// -DPACK_GAME_STATE drops the alignment padding at the end of each entity
+// pool, for cards whose CPU reads unaligned data cheaply (pool arrays may
+// then start at odd addresses and compile to byte loads)
+#if defined(PACK_GAME_STATE) && defined(__GNUC__)
+#define STATE_PACKED __attribute__((packed))
+#else
+#define STATE_PACKED
+#endif
+
+// Large worlds: the level is baked into NVM in chunks at level start and
+// streamed through a small RAM cache, so the map can be far larger than
+// RAM (see map_stream.c)
+#ifdef LARGE_WORLD
+#define MAP_STREAMED 1
+#else
+#define MAP_STREAMED 0
+#endif
+
+// Compiled levels: -DLEVEL_BLOBS plays hand-made maps that "make levels"
+// compiles into blobs for ROM (tools/level_compiler.c) instead of
+// generating each level from the seed
+#ifdef LEVEL_BLOBS
+#define LEVEL_COMPILED 1
+#else
+#define LEVEL_COMPILED 0
+#endif
+
+#if LEVEL_COMPILED && MAP_STREAMED
+#error "Compiled levels live in ROM; LARGE_WORLD levels are generated"
+#endif
+
+// Viewport. Card builds draw the profile's fixed SCREEN_W x SCREEN_H, which
+// the renderer folds in as constants. Host builds (RUNTIME_VIEWPORT) start
+// at that size and may pick any other from VIEW_MIN up to VIEW_MAX with
+// set_viewport(). The simulation (AI tiers, rifle reach) always uses
+// SCREEN_W x SCREEN_H, so a game plays the same at every size.
+#ifndef RUNTIME_VIEWPORT
+#ifdef SIM_CARD_TARGET
+#define RUNTIME_VIEWPORT 0
+#else
+#define RUNTIME_VIEWPORT 1
+#endif
+#endif
+
+#if RUNTIME_VIEWPORT
+#define VIEW_MIN_W 40       // Widest fixed text line (help) fits
+#define VIEW_MIN_H 25
+#define VIEW_MAX_W 200
+#define VIEW_MAX_H 60
+static uint8_t view_w = SCREEN_W;
+static uint8_t view_h = SCREEN_H;
+#define VIEW_W ((int)view_w)
+#define VIEW_H ((int)view_h)
+STATIC_ASSERT(SCREEN_W >= VIEW_MIN_W && SCREEN_W <= VIEW_MAX_W &&
+              SCREEN_H >= VIEW_MIN_H && SCREEN_H <= VIEW_MAX_H, default_viewport_in_range);
+#else
+#define VIEW_MAX_W SCREEN_W
+#define VIEW_MAX_H SCREEN_H
+#define VIEW_W SCREEN_W
+#define VIEW_H SCREEN_H
 #endif
 
 // Fixed-point math for positions (8.8 format)
@@ -31,12 +106,37 @@
 #define FP_SCALE (1 << FP_SHIFT)
 #define FP_HALF (FP_SCALE / 2)
 
+// Position type (width picked per profile) and the signed type of a
+// velocity or step. COORD_TILE is a shift, never a division: it floors, so
+// a step off the left edge still lands on tile -1.
+#if COORD_BITS == 32
+typedef int32_t coord_t;
+typedef int32_t coord_delta_t;
+#define COORD_MAX_TILES 0x7FFFFF
+#elif COORD_SIGNED
+typedef int16_t coord_t;
+typedef int16_t coord_delta_t;
+#define COORD_MAX_TILES 128
+#else
+typedef uint16_t coord_t;
+typedef int16_t coord_delta_t;
+#define COORD_MAX_TILES 256
+#endif
+
+#define COORD_TILE(c) ((int)((c) >> FP_SHIFT))
+#define TILE_COORD(t) ((coord_t)((t) << FP_SHIFT))
+
+#if MAP_W > COORD_MAX_TILES || MAP_H > COORD_MAX_TILES
+#error "Map is wider than the profile's coordinate type can address"
+#endif
+
 // Map tiles
 #define TILE_EMPTY   0
 #define TILE_WALL    1
 #define TILE_EXIT    2
 #define TILE_AMMO    3
 #define TILE_HEALTH  4
+#define TILE_DOOR    5
 
 // ASCII characters for display
 #define CHAR_EMPTY   ' '
@@ -47,6 +147,7 @@
 #define CHAR_AMMO    'a'
 #define CHAR_HEALTH  '+'
 #define CHAR_EXIT    'X'
+#define CHAR_DOOR    'D'
 #define CHAR_CORPSE  '%'
 
 // Direction constants
@@ -57,118 +158,1187 @@ typedef enum {
     DIR_WEST = 270
 } Direction;
 
-// Entity structures
+// Weapons. The blaster fires projectiles from the bullet pool, which fly a
+// few tiles per tick; the rifle is hitscan: trace_shot() walks the tile
+// grid and the shot is resolved the moment it is fired.
+#define WEAPON_BLASTER  0
+#define WEAPON_RIFLE    1
+#define WEAPON_COUNT    2
+
 typedef struct {
-    int16_t x, y;        // Fixed-point position
-    int16_t dx, dy;      // Velocity
-    bool active;
-} Bullet;
+    const char* name;
+    bool hitscan;
+    uint8_t range;          // Hitscan reach in tiles
+} WeaponDef;
+
+static const WeaponDef weapons[WEAPON_COUNT] = {
+    {"BLASTER", false, 0},
+    {"RIFLE",   true,  SCREEN_W / 2},
+};
+
+// Dense entity kernels: host CPUs run a branch-free pass over every pool
+// slot so the compiler can vectorize it. Card toolchains define
+// SIM_CARD_TARGET and walk only the live bits instead.
+#ifndef DENSE_ENTITY_KERNELS
+#ifdef SIM_CARD_TARGET
+#define DENSE_ENTITY_KERNELS 0
+#else
+#define DENSE_ENTITY_KERNELS 1
+#endif
+#endif
+
+// Slots per SoA array: dense builds round up to whole 16-byte vectors of
+// 16-bit coordinates so the movement pass needs no scalar tail
+#if DENSE_ENTITY_KERNELS
+#define POOL_LANES(n) (((n) + 7) & ~7)
+#else
+#define POOL_LANES(n) (n)
+#endif
+
+// Live-slot bitmasks (one bit per pool slot, as narrow as the pool allows)
+#if MAX_ENEMIES <= 8
+typedef uint8_t EnemyMask;
+#elif MAX_ENEMIES <= 16
+typedef uint16_t EnemyMask;
+#elif MAX_ENEMIES <= 32
+typedef uint32_t EnemyMask;
+#else
+typedef uint64_t EnemyMask;
+#endif
+
+#if MAX_BULLETS <= 8
+typedef uint8_t BulletMask;
+#elif MAX_BULLETS <= 16
+typedef uint16_t BulletMask;
+#elif MAX_BULLETS <= 32
+typedef uint32_t BulletMask;
+#else
+typedef uint64_t BulletMask;
+#endif
+
+#define SLOT_BIT(type, i) ((type)((type)1 << (i)))
+#define SLOTS_ALL(type, n) ((n) ? (type)((type)~(type)0 >> (sizeof(type) * 8 - (n))) : (type)0)
+
+// Index of the lowest set bit (mask must be non-zero)
+#if defined(__GNUC__)
+#define SLOT_LOWEST(m) ((uint8_t)__builtin_ctzll((unsigned long long)(m)))
+#else
+static uint8_t slot_lowest_portable(uint64_t m) {
+    uint8_t i = 0;
+    while (!(m & 0xFF)) { m >>= 8; i += 8; }
+    while (!(m & 1)) { m >>= 1; i++; }
+    return i;
+}
+#define SLOT_LOWEST(m) slot_lowest_portable(m)
+#endif
+
+// Visit each set bit of a snapshot of 'mask', lowest slot first
+#define FOR_EACH_LIVE(type, mask, i) \
+    for (type live_##i = (mask); live_##i && (((i) = SLOT_LOWEST(live_##i)), 1); \
+         live_##i &= (type)(live_##i - 1))
+
+// Pool arrays. Fixed profiles embed them at full size; the adaptive
+// profile points them into the level arena, sized per card (carve_pools),
+// and MAX_ENEMIES / MAX_BULLETS are only ceilings.
+#if ADAPTIVE_CAPACITY
+#define POOL_ARRAY(type, name, n) type* name
+#define ENEMY_CAP(g)  ((g)->enemy_cap)
+#define BULLET_CAP(g) ((g)->bullet_cap)
+#else
+#define POOL_ARRAY(type, name, n) type name[n]
+#define ENEMY_CAP(g)  MAX_ENEMIES
+#define BULLET_CAP(g) MAX_BULLETS
+#endif
+
+// Entity pools (structure-of-arrays, no per-entity flags or padding)
+typedef struct STATE_PACKED {
+    POOL_ARRAY(coord_t, x, POOL_LANES(MAX_BULLETS));        // Fixed-point position
+    POOL_ARRAY(coord_t, y, POOL_LANES(MAX_BULLETS));
+    POOL_ARRAY(coord_delta_t, dx, POOL_LANES(MAX_BULLETS)); // Velocity (zero while the slot is free)
+    POOL_ARRAY(coord_delta_t, dy, POOL_LANES(MAX_BULLETS));
+    BulletMask live;
+} BulletPool;
+
+// Enemies act every ENEMY_SPEED ticks. Rather than counting down a timer in
+// every enemy every tick, each one books its next turn on a timing wheel:
+// slot t % ENEMY_WHEEL_SLOTS holds the enemies due at tick t, so a tick only
+// visits the enemies that act on it. Waits run from 1 to ENEMY_WHEEL_SLOTS.
+#define ENEMY_WHEEL_SLOTS 16        // Power of two
+#define ENEMY_WHEEL_SLOT(t) ((uint8_t)((t) & (ENEMY_WHEEL_SLOTS - 1)))
+
+// Enemies start idle: off the wheel, costing nothing, until a noise spreads
+// to their room or the player's room can see it (see alert_rooms()).
+//
+// AI level of detail, by distance from the player in tiles. Inside the near
+// box (the screen plus how far the player can walk in one coarse wait) an
+// enemy takes a turn every ENEMY_SPEED ticks. Between it and the wake box
+// (the near box plus how far the player can walk in one dormant wait) it
+// acts AI_COARSE_TURNS times less often and catches up on the turns it
+// skipped in one closed-form move (see enemy_catch_up()). Beyond the wake
+// box it is dormant: it stays put, checks the distance again every
+// ENEMY_WHEEL_SLOTS ticks, and catches up on the last wait once the player
+// is back inside the wake box. No tile is further than the map size less
+// one, so a box that reaches that far covers the whole map and on small
+// maps every enemy is near.
+#define AI_COARSE_TURNS   4
+#define AI_COARSE_WAIT    (AI_COARSE_TURNS * ENEMY_SPEED)
+#define AI_DORMANT_WAIT   ENEMY_WHEEL_SLOTS
+#define AI_DORMANT_TURNS  (AI_DORMANT_WAIT / ENEMY_SPEED)
+#define AI_REACH(wait)    ((wait) / 2)              // Player moves half a tile per tick
+#define AI_FIT(r, map)    ((r) < (map) - 1 ? (r) : (map) - 1)
+#define AI_NEAR_X         AI_FIT(SCREEN_W / 2 + AI_REACH(AI_COARSE_WAIT), MAP_W)
+#define AI_NEAR_Y         AI_FIT(SCREEN_H / 2 + AI_REACH(AI_COARSE_WAIT), MAP_H)
+#define AI_WAKE_X         AI_FIT(AI_NEAR_X + AI_REACH(AI_DORMANT_WAIT), MAP_W)
+#define AI_WAKE_Y         AI_FIT(AI_NEAR_Y + AI_REACH(AI_DORMANT_WAIT), MAP_H)
+
+STATIC_ASSERT((ENEMY_WHEEL_SLOTS & (ENEMY_WHEEL_SLOTS - 1)) == 0, enemy_wheel_is_power_of_two);
+STATIC_ASSERT(ENEMY_SPEED >= 1 && AI_COARSE_WAIT <= ENEMY_WHEEL_SLOTS, enemy_waits_fit_wheel);
+
+typedef struct STATE_PACKED {
+    POOL_ARRAY(coord_t, x, MAX_ENEMIES);        // Fixed-point position
+    POOL_ARRAY(coord_t, y, MAX_ENEMIES);
+    POOL_ARRAY(uint8_t, health, MAX_ENEMIES);
+    EnemyMask live;
+    EnemyMask idle;                             // Not yet alerted; not on the wheel
+    EnemyMask coarse;                           // Booked to catch up AI_COARSE_TURNS turns
+    EnemyMask dormant;                          // Booked only to check the distance
+    EnemyMask wake[ENEMY_WHEEL_SLOTS];          // Bits may outlive their enemy
+} EnemyPool;
+
+// Procedural levels. A level is a handful of rooms on a grid of
+// LEVEL_CELL-sized cells, joined in order by L-shaped corridors, with
+// pickups scattered through the rooms. Only this descriptor lives in RAM;
+// level_tile() derives any tile on demand and the player's changes to the
+// level are two bitmasks (pickups taken, doors opened).
+#define LEVEL_CELL      10
+#define LEVEL_CELLS_X   (MAP_W / LEVEL_CELL)
+#define LEVEL_CELLS_Y   (MAP_H / LEVEL_CELL)
+#define LEVEL_CELLS     (LEVEL_CELLS_X * LEVEL_CELLS_Y)
+#define LEVEL_ROOM_MIN  3
+#define LEVEL_ROOM_MAX  (LEVEL_CELL - 3)
+
+// Streamed worlds are bigger and no longer pay for rooms on every lookup
+#if MAP_STREAMED
+#define LEVEL_ROOM_CAP  32
+#define LEVEL_ROOMS(level) (LEVEL_ROOM_CAP / 2 + (level))
+#else
+#define LEVEL_ROOM_CAP  8
+#define LEVEL_ROOMS(level) (2 + (level))
+#endif
+
+#if LEVEL_CELLS < 2
+#error "Map too small for the level generator (needs two LEVEL_CELL cells)"
+#elif LEVEL_CELLS < LEVEL_ROOM_CAP
+#define LEVEL_MAX_ROOMS LEVEL_CELLS
+#else
+#define LEVEL_MAX_ROOMS LEVEL_ROOM_CAP
+#endif
+
+#if MAX_PICKUPS <= 8
+typedef uint8_t PickupMask;
+#elif MAX_PICKUPS <= 16
+typedef uint16_t PickupMask;
+#else
+typedef uint32_t PickupMask;
+#endif
+
+// One bit per corridor
+#if LEVEL_MAX_ROOMS <= 9
+typedef uint8_t DoorMask;
+#elif LEVEL_MAX_ROOMS <= 17
+typedef uint16_t DoorMask;
+#else
+typedef uint32_t DoorMask;
+#endif
+
+// One bit per room (rooms are the regions noise and sight spread through)
+#if LEVEL_MAX_ROOMS <= 8
+typedef uint8_t RoomMask;
+#elif LEVEL_MAX_ROOMS <= 16
+typedef uint16_t RoomMask;
+#else
+typedef uint32_t RoomMask;
+#endif
 
 typedef struct {
-    int16_t x, y;        // Fixed-point position
-    uint8_t health;
-    uint8_t move_timer;
-    bool active;
-} Enemy;
+    uint8_t x, y, w, h;
+} LevelRoom;
+
+typedef struct {
+    uint8_t x, y;
+    uint8_t tile;           // TILE_AMMO or TILE_HEALTH
+} LevelPickup;
+
+typedef struct {
+    uint8_t x, y;           // x == 0 means the corridor has no door
+} LevelDoor;
+
+#if LEVEL_COMPILED
+// Compiled level blob (read in place from ROM, except the walls):
+//   header(16)  'L' 'V' version flags w h player(x y) exit(x y)
+//               doors pickups spawns regions rects 0
+//   doors       x y per door
+//   pickups     x y tile per pickup
+//   spawns      x y per enemy
+//   nav         (LEVEL_BLOB_NAV) rects: x y w h region; the two regions
+//               each door joins; an anchor tile x y per region
+//   sight       (LEVEL_BLOB_SIGHT) per region a, 16-bit big-endian mask of
+//               the regions b > a it sees with every door closed
+//   walls       h compressed rows (see level_decode_row) and a pad byte,
+//               decoded into RAM as the level loads
+// Regions play the part of rooms for noise and sight: the floor between
+// doors, each the union of its rects (which may overlap walls).
+#define LEVEL_BLOB_MAGIC0   'L'
+#define LEVEL_BLOB_MAGIC1   'V'
+#define LEVEL_BLOB_VERSION  2
+#define LEVEL_BLOB_HEADER   16
+#define LEVEL_BLOB_NAV      0x01
+#define LEVEL_BLOB_SIGHT    0x02
+
+// Header bytes
+#define LB_VERSION  2
+#define LB_FLAGS    3
+#define LB_W        4
+#define LB_H        5
+#define LB_PLAYER   6
+#define LB_EXIT     8
+#define LB_DOORS    10
+#define LB_PICKUPS  11
+#define LB_SPAWNS   12
+#define LB_REGIONS  13
+#define LB_RECTS    14
+
+// Sections after the header, in blob order
+#define LEVEL_BLOB_DOORS    0
+#define LEVEL_BLOB_PICKUPS  1
+#define LEVEL_BLOB_SPAWNS   2
+#define LEVEL_BLOB_RECTS    3
+#define LEVEL_BLOB_JOINS    4
+#define LEVEL_BLOB_ANCHORS  5
+#define LEVEL_BLOB_SIGHTS   6
+#define LEVEL_BLOB_WALLS    7
+
+// Decoded walls: a bit per tile, rows of LEVEL_ROW_BYTES, in the level arena
+#define LEVEL_ROW_BYTES(w) (((w) + 7) >> 3)
+#define LEVEL_WALL_RAM (MAP_H * LEVEL_ROW_BYTES(MAP_W))
+STATIC_ASSERT(LEVEL_WALL_RAM < ARENA_LEVEL_SIZE, compiled_walls_fit_level_arena);
+
+// Compiled levels (make levels): blob i is level i + 1
+extern const uint8_t* const level_blobs[];
+extern const uint8_t level_blob_count;
+
+#define LEVEL_BLOB(game) (level_blobs[(game)->level - 1])
+#define LEVEL_COUNT level_blob_count
+
+// Decoded from the blob header and tables; nav data stays in ROM
+typedef struct {
+    LevelDoor doors[LEVEL_MAX_ROOMS - 1];
+    LevelPickup pickups[MAX_PICKUPS];
+    uint8_t w, h;                           // Compiled map; beyond it is wall
+    uint8_t exit_x, exit_y;
+    uint8_t room_count;                     // Regions (0: the blob has no nav data)
+    uint8_t door_count;
+    uint8_t pickup_count;
+} LevelDesc;
+
+#define LEVEL_EXIT_X(L) ((L)->exit_x)
+#define LEVEL_EXIT_Y(L) ((L)->exit_y)
+#define LEVEL_DOOR_COUNT(L) ((L)->door_count)
+#define LEVEL_PICKUP_COUNT(L) ((L)->pickup_count)
+#else
+typedef struct {
+    LevelRoom rooms[LEVEL_MAX_ROOMS];       // Corridor i joins room i to i+1
+    LevelDoor doors[LEVEL_MAX_ROOMS - 1];   // Where corridor i leaves room i
+    LevelPickup pickups[MAX_PICKUPS];
+    uint8_t room_count;
+} LevelDesc;
+
+#define LEVEL_COUNT MAX_LEVELS
+#endif
+
+// The descriptor is all bytes: no padding anywhere
+STATIC_ASSERT(sizeof(LevelRoom) == 4, level_room_is_4_bytes);
+STATIC_ASSERT(sizeof(LevelPickup) == 3, level_pickup_is_3_bytes);
+STATIC_ASSERT(sizeof(LevelDoor) == 2, level_door_is_2_bytes);
+
+#define ROOM_CX(r) ((r)->x + (r)->w / 2)
+#define ROOM_CY(r) ((r)->y + (r)->h / 2)
 
-// Main game state - must fit in SIM memory!
+#if !LEVEL_COMPILED
+// The exit sits in the centre of the last room
+#define LEVEL_EXIT_X(L) ROOM_CX(&(L)->rooms[(L)->room_count - 1])
+#define LEVEL_EXIT_Y(L) ROOM_CY(&(L)->rooms[(L)->room_count - 1])
+#define LEVEL_DOOR_COUNT(L) ((L)->room_count - 1)
+#define LEVEL_PICKUP_COUNT(L) MAX_PICKUPS
+#endif
+
+// Level build stages. Levels are built a slice at a time across several
+// ticks (one slice per UPDATE_GAME on the card) so no single command has
+// to pay for a whole level; the game is "loading" until LEVEL_STAGE_READY.
+#define LEVEL_STAGE_LAYOUT  0   // Generate the level descriptor
+#define LEVEL_STAGE_SPAWN   1   // Place the player and enemies
+#define LEVEL_STAGE_BAKE    2   // Streamed maps: write chunks to NVM
+#define LEVEL_STAGE_READY   3
+
+// Chunks baked per step (programs at most LEVEL_BAKE_CHUNKS / 2 NVM pages)
+#define LEVEL_BAKE_CHUNKS   32
+
+#define LEVEL_LOADING(g) ((g)->build_stage != LEVEL_STAGE_READY)
+
+// Main game state - must fit in SIM memory! Fields are grouped by
+// alignment, widest first, so the struct carries no interior padding on any
+// profile (make memory-report shows the layout); the two flags share a byte.
 typedef struct {
-    // Player state
-    int16_t player_x, player_y;
+    // 32-bit: seed and PRNG streams
+    uint32_t seed;           // Seed the current game was started from
+    uint32_t rng;            // PRNG state (all simulation randomness comes from here)
+    uint32_t build_rng;      // Level generator stream, carried between build stages
+    
+    // Level edits (masks up to 32 bits wide)
+    PickupMask pickups_taken;
+    DoorMask doors_open;
+    
+    // Entities
+    EnemyPool enemies;
+    BulletPool bullets;
+    
+    // Player position, then 16-bit counters
+    coord_t player_x, player_y;
     uint16_t player_angle;
+    uint16_t frame_count;
+    uint16_t build_pos;      // Level build progress within the stage
+    
+    // Bytes
     uint8_t health;
     uint8_t ammo;
-    
-    // Game state
     uint8_t level;
-    uint16_t frame_count;
-    bool game_over;
-    bool victory;
+    uint8_t build_stage;     // See level_build_step
+    uint8_t weapon;          // WEAPON_BLASTER or WEAPON_RIFLE
+#if ADAPTIVE_CAPACITY
+    uint8_t enemy_cap;       // Pool slots this card can afford
+    uint8_t bullet_cap;
+#endif
+    bool game_over : 1;
+    bool victory : 1;
     
-    // Entities
-    Enemy enemies[MAX_ENEMIES];
-    Bullet bullets[MAX_BULLETS];
+    // Generated layout (byte-sized fields only)
+    LevelDesc layout;
+} GameState;
+
+// A rendered frame, for hosts that keep one. Not part of GameState: it is
+// derived data, and the card renders rows straight into its response.
+// Row y is the first w bytes at cells + y * stride.
+typedef struct {
+    uint8_t* cells;
+    uint16_t stride;
+    uint8_t w, h;
+} Frame;
+
+#define FRAME_AT(f, x, y) ((f)->cells[(y) * (f)->stride + (x)])
+
+// Seed used when the host does not supply one
+#define GAME_DEFAULT_SEED 0x0001D00Du
+
+// Seeded xorshift32 PRNG. The simulation never calls rand(): a seed plus
+// the input stream reproduces a game exactly on every build.
+static uint32_t xorshift32(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+uint32_t game_rand(GameState* game) {
+    return xorshift32(&game->rng);
+}
+
+// Uniform-enough value in [0, n) from the high bits
+uint16_t game_rand_below(GameState* game, uint16_t n) {
+    return (uint16_t)((game_rand(game) >> 16) % n);
+}
+
+#if !LEVEL_COMPILED
+// Level generation draws from its own stream (seed mixed with the level
+// number) so rebuilding a level never disturbs game->rng
+static uint16_t level_rand_below(uint32_t* state, uint16_t n) {
+    return (uint16_t)((xorshift32(state) >> 16) % n);
+}
+#endif
+
+#if LEVEL_COMPILED
+// Start of a section of 'blob' (LEVEL_BLOB_DOORS ... LEVEL_BLOB_WALLS)
+static const uint8_t* level_blob_section(const uint8_t* blob, int section) {
+    uint16_t size[LEVEL_BLOB_WALLS];
+    uint16_t at = LEVEL_BLOB_HEADER;
     
-    // Map (1 bit per tile would save memory, but we'll use bytes for simplicity)
-    uint8_t map[MAP_H][MAP_W];
+    size[LEVEL_BLOB_DOORS] = (uint16_t)(2 * blob[LB_DOORS]);
+    size[LEVEL_BLOB_PICKUPS] = (uint16_t)(3 * blob[LB_PICKUPS]);
+    size[LEVEL_BLOB_SPAWNS] = (uint16_t)(2 * blob[LB_SPAWNS]);
+    size[LEVEL_BLOB_RECTS] = (uint16_t)(5 * blob[LB_RECTS]);
+    size[LEVEL_BLOB_JOINS] = (blob[LB_FLAGS] & LEVEL_BLOB_NAV) ? (uint16_t)(2 * blob[LB_DOORS]) : 0;
+    size[LEVEL_BLOB_ANCHORS] = (uint16_t)(2 * blob[LB_REGIONS]);
+    size[LEVEL_BLOB_SIGHTS] = (blob[LB_FLAGS] & LEVEL_BLOB_SIGHT) ? (uint16_t)(2 * blob[LB_REGIONS]) : 0;
+    for (int i = 0; i < section; i++) at = (uint16_t)(at + size[i]);
+    return blob + at;
+}
+
+// Walls of the current level, decoded by load_level()
+static uint8_t* level_walls;
+
+// Reader for the compressed walls, most significant bit first. Its
+// position is all the working memory the decoder needs.
+typedef struct {
+    const uint8_t* src;
+    uint16_t pos;           // Next bit
+} LevelBits;
+
+// The next 'n' bits (1 to 8), from a 16-bit window: the walls end with a
+// pad byte so the window never leaves the blob
+static uint8_t level_bits(LevelBits* in, int n) {
+    const uint8_t* p = in->src + (in->pos >> 3);
+    uint16_t window = (uint16_t)(p[0] << 8 | p[1]);
     
-    // Screen buffer
-    uint8_t screen[SCREEN_H][SCREEN_W];
-} GameState;
+    window = (uint16_t)(window >> (16 - (in->pos & 7) - n));
+    in->pos = (uint16_t)(in->pos + n);
+    return (uint8_t)(window & ((1u << n) - 1));
+}
 
-// Initialize a level
-void init_level(GameState* game, uint8_t level) {
-    // Clear map
-    memset(game->map, TILE_EMPTY, sizeof(game->map));
+// Set tiles x to end - 1 of 'row', a byte at a time where it can
+static void level_fill_row(uint8_t* row, int x, int end) {
+    for (; x < end && (x & 7); x++) row[x >> 3] |= (uint8_t)(0x80 >> (x & 7));
+    for (; x + 8 <= end; x += 8) row[x >> 3] = 0xFF;
+    for (; x < end; x++) row[x >> 3] |= (uint8_t)(0x80 >> (x & 7));
+}
+
+// Decode the next row of walls straight into 'row' (w tiles, bit 7 first,
+// the row above just before it). A row is a flag bit, 0 to repeat the row
+// above, or 1 and then alternating wall and floor runs, starting with
+// wall, whose lengths come in 4-bit pieces (a 15 means another piece
+// follows).
+static void level_decode_row(LevelBits* in, uint8_t* row, int w) {
+    int bytes = LEVEL_ROW_BYTES(w), x = 0, wall = 1;
+    
+    if (!level_bits(in, 1)) {
+        memcpy(row, row - bytes, (size_t)bytes);
+        return;
+    }
+    memset(row, 0, (size_t)bytes);
+    while (x < w) {
+        int run = 0, piece;
+        do {
+            piece = level_bits(in, 4);
+            run += piece;
+        } while (piece == 15);
+        
+        int end = x + run < w ? x + run : w;
+        if (wall) level_fill_row(row, x, end);
+        x = end;
+        wall = !wall;
+    }
+}
+
+#else
+static bool room_contains(const LevelRoom* r, int x, int y) {
+    return x >= r->x && x < r->x + r->w && y >= r->y && y < r->y + r->h;
+}
+
+// Corridor i runs horizontally from the centre of room i, then vertically
+// into the centre of room i+1
+static bool corridor_contains(const LevelDesc* L, int i, int x, int y) {
+    int x0 = ROOM_CX(&L->rooms[i]), y0 = ROOM_CY(&L->rooms[i]);
+    int x1 = ROOM_CX(&L->rooms[i + 1]), y1 = ROOM_CY(&L->rooms[i + 1]);
+    
+    if (y == y0 && x >= (x0 < x1 ? x0 : x1) && x <= (x0 < x1 ? x1 : x0)) return true;
+    return x == x1 && y >= (y0 < y1 ? y0 : y1) && y <= (y0 < y1 ? y1 : y0);
+}
+#endif
+
+// Index of the untaken pickup at (x, y), or -1
+int level_pickup_at(const GameState* game, int x, int y) {
+    for (int i = 0; i < MAX_PICKUPS; i++) {
+        const LevelPickup* p = &game->layout.pickups[i];
+        if (p->x == x && p->y == y && !(game->pickups_taken & SLOT_BIT(PickupMask, i))) return i;
+    }
+    return -1;
+}
+
+// Index of the closed door at (x, y), or -1
+int level_door_at(const GameState* game, int x, int y) {
+    for (int i = 0; i < LEVEL_DOOR_COUNT(&game->layout); i++) {
+        const LevelDoor* d = &game->layout.doors[i];
+        if (d->x && d->x == x && d->y == y && !(game->doors_open & SLOT_BIT(DoorMask, i))) return i;
+    }
+    return -1;
+}
+
+// Tile at (x, y), derived from the level descriptor and the player's edits
+#if LEVEL_COMPILED
+uint8_t level_tile(const GameState* game, int x, int y) {
+    const LevelDesc* L = &game->layout;
+    int i;
+    
+    // Compiled maps are walled in, and only floor can hold anything else
+    if (x < 0 || y < 0 || x >= L->w || y >= L->h) return TILE_WALL;
+    const uint8_t* row = level_walls + y * LEVEL_ROW_BYTES(L->w);
+    if (row[x >> 3] & (0x80 >> (x & 7))) return TILE_WALL;
+    if (x == L->exit_x && y == L->exit_y) return TILE_EXIT;
+    
+    i = level_pickup_at(game, x, y);
+    if (i >= 0) return L->pickups[i].tile;
+    if (level_door_at(game, x, y) >= 0) return TILE_DOOR;
+    return TILE_EMPTY;
+}
+#else
+uint8_t level_tile(const GameState* game, int x, int y) {
+    const LevelDesc* L = &game->layout;
+    int i;
+    
+    // Border walls
+    if (x <= 0 || y <= 0 || x >= MAP_W - 1 || y >= MAP_H - 1) return TILE_WALL;
+    
+    if (x == LEVEL_EXIT_X(L) && y == LEVEL_EXIT_Y(L)) return TILE_EXIT;
+    
+    i = level_pickup_at(game, x, y);
+    if (i >= 0) return L->pickups[i].tile;
+    if (level_door_at(game, x, y) >= 0) return TILE_DOOR;
+    
+    for (i = 0; i < L->room_count; i++) {
+        if (room_contains(&L->rooms[i], x, y)) return TILE_EMPTY;
+    }
+    for (i = 0; i < L->room_count - 1; i++) {
+        if (corridor_contains(L, i, x, y)) return TILE_EMPTY;
+    }
+    return TILE_WALL;
+}
+#endif
+
+#include "map_stream.c"
+
+// Tile at (x, y) as the game sees it. Small maps derive it from the level
+// descriptor; streamed maps read the baked tile and consult the edit masks
+// only for pickups and doors.
+uint8_t map_tile(const GameState* game, int x, int y) {
+#if MAP_STREAMED
+    if (x < 0 || y < 0 || x >= MAP_W || y >= MAP_H) return TILE_WALL;
+    
+    uint8_t tile = map_stream_tile(x, y);
+    if (tile == TILE_AMMO || tile == TILE_HEALTH) {
+        int i = level_pickup_at(game, x, y);
+        return i >= 0 ? game->layout.pickups[i].tile : TILE_EMPTY;
+    }
+    if (tile == TILE_DOOR && level_door_at(game, x, y) < 0) return TILE_EMPTY;
+    return tile;
+#else
+    return level_tile(game, x, y);
+#endif
+}
+
+#if LEVEL_COMPILED
+// Decode the descriptor for 'level' from its blob, and its walls a row at
+// a time into the level arena (just released by begin_level(); adaptive
+// pools take what is left). Returns false on a card whose level arena
+// cannot hold the walls: the level is then 0x0, all wall.
+static bool load_level(GameState* game) {
+    LevelDesc* L = &game->layout;
+    const uint8_t* blob = LEVEL_BLOB(game);
+    const uint8_t* doors = level_blob_section(blob, LEVEL_BLOB_DOORS);
+    const uint8_t* pickups = level_blob_section(blob, LEVEL_BLOB_PICKUPS);
+    LevelBits walls = {level_blob_section(blob, LEVEL_BLOB_WALLS), 0};
+    int i;
+    
+    memset(L, 0, sizeof(*L));
+    level_walls = sim_arena_alloc(ARENA_LEVEL, (uint16_t)(blob[LB_H] * LEVEL_ROW_BYTES(blob[LB_W])));
+    if (!level_walls) return false;
+    for (i = 0; i < blob[LB_H]; i++) {
+        level_decode_row(&walls, level_walls + i * LEVEL_ROW_BYTES(blob[LB_W]), blob[LB_W]);
+    }
+    
+    L->w = blob[LB_W];
+    L->h = blob[LB_H];
+    L->exit_x = blob[LB_EXIT];
+    L->exit_y = blob[LB_EXIT + 1];
+    L->room_count = blob[LB_REGIONS];
+    L->door_count = blob[LB_DOORS];
+    L->pickup_count = blob[LB_PICKUPS];
+    for (i = 0; i < L->door_count; i++) {
+        L->doors[i].x = doors[2 * i];
+        L->doors[i].y = doors[2 * i + 1];
+    }
+    for (i = 0; i < L->pickup_count; i++) {
+        L->pickups[i].x = pickups[3 * i];
+        L->pickups[i].y = pickups[3 * i + 1];
+        L->pickups[i].tile = pickups[3 * i + 2];
+    }
+    return true;
+}
+#else
+// Place a door on the first tile where corridor i leaves room i. That tile
+// is in the room's own cell margin, so it never lands inside another room.
+static void place_door(LevelDesc* L, int i) {
+    const LevelRoom* from = &L->rooms[i];
+    int x = ROOM_CX(from), y = ROOM_CY(from);
+    int x1 = ROOM_CX(&L->rooms[i + 1]), y1 = ROOM_CY(&L->rooms[i + 1]);
+    
+    while (room_contains(from, x, y)) {
+        if (x != x1) x += (x < x1) ? 1 : -1;
+        else if (y != y1) y += (y < y1) ? 1 : -1;
+        else return;
+    }
+    L->doors[i].x = (uint8_t)x;
+    L->doors[i].y = (uint8_t)y;
+}
+
+// Build the descriptor for 'level' from game->seed
+static void generate_level(GameState* game, uint8_t level, uint32_t* rs) {
+    LevelDesc* L = &game->layout;
+    memset(L, 0, sizeof(*L));
+    
+    // Choose rooms by selection sampling over the cells in serpentine
+    // order, so consecutive rooms (and their corridors) stay close together
+    int want = LEVEL_ROOMS(level);
+    if (want > LEVEL_MAX_ROOMS) want = LEVEL_MAX_ROOMS;
+    
+    for (int k = 0; k < LEVEL_CELLS && L->room_count < want; k++) {
+        if (level_rand_below(rs, (uint16_t)(LEVEL_CELLS - k)) >= want - L->room_count) continue;
+        
+        int cy = k / LEVEL_CELLS_X;
+        int cx = (cy & 1) ? LEVEL_CELLS_X - 1 - k % LEVEL_CELLS_X : k % LEVEL_CELLS_X;
+        LevelRoom* r = &L->rooms[L->room_count++];
+        
+        // Keep a one-tile margin inside the cell so rooms never touch
+        r->w = (uint8_t)(LEVEL_ROOM_MIN + level_rand_below(rs, LEVEL_ROOM_MAX - LEVEL_ROOM_MIN + 1));
+        r->h = (uint8_t)(LEVEL_ROOM_MIN + level_rand_below(rs, LEVEL_ROOM_MAX - LEVEL_ROOM_MIN + 1));
+        r->x = (uint8_t)(cx * LEVEL_CELL + 1 + level_rand_below(rs, (uint16_t)(LEVEL_CELL - 1 - r->w)));
+        r->y = (uint8_t)(cy * LEVEL_CELL + 1 + level_rand_below(rs, (uint16_t)(LEVEL_CELL - 1 - r->h)));
+    }
+    
+    // Doors on about half of the corridors
+    for (int i = 0; i < L->room_count - 1; i++) {
+        if (xorshift32(rs) & 0x10000) place_door(L, i);
+    }
+    
+    // Pickups go in random rooms, off the room centres (spawn and exit)
+    for (int i = 0; i < MAX_PICKUPS; i++) {
+        const LevelRoom* r = &L->rooms[level_rand_below(rs, L->room_count)];
+        LevelPickup* p = &L->pickups[i];
+        p->x = (uint8_t)(r->x + level_rand_below(rs, r->w));
+        p->y = (uint8_t)(r->y + level_rand_below(rs, r->h));
+        if (p->x == ROOM_CX(r) && p->y == ROOM_CY(r)) p->x = r->x;
+        p->tile = level_rand_below(rs, 3) ? TILE_AMMO : TILE_HEALTH;
+    }
+}
+#endif
+
+// Sight lines between rooms, traced on first use (see rooms_see()) and
+// kept until a door opens. It is derived data, so it lives in the level
+// arena rather than in GameState; with no room for it every check traces.
+typedef struct {
+    RoomMask known[LEVEL_MAX_ROOMS];    // known[a] bit b: pair (a < b) traced
+    RoomMask clear[LEVEL_MAX_ROOMS];    // ...and nothing is in the way
+} RoomSight;
+
+static RoomSight* room_sight;
+
+// Forget every sight line: call whenever a door opens, or the doors are
+// set some other way (a loaded save)
+void reset_room_sight(void) {
+    if (room_sight) memset(room_sight, 0, sizeof(RoomSight));
+}
+
+// The level generator's stream for 'level' of the game seeded 'seed'
+static uint32_t level_build_rng(uint32_t seed, uint8_t level) {
+    uint32_t rs = seed ^ (level * 0x9E3779B9u);
+    return rs ? rs : GAME_DEFAULT_SEED;
+}
+
+// Start building 'level' (from game->seed, which must be set). The game is
+// loading until level_build_step() reports the level ready. Everything in
+// the level arena belongs to the previous level and is released.
+void begin_level(GameState* game, uint8_t level) {
+    sim_arena_reset(ARENA_LEVEL);
+    room_sight = NULL;
+#if LEVEL_COMPILED
+    level_walls = NULL;
+#endif
+    game->enemies.live = 0;      // The old level's entities go with it
+    game->bullets.live = 0;
+    game->level = level;
+    game->build_stage = LEVEL_STAGE_LAYOUT;
+    game->build_pos = 0;
+    game->build_rng = level_build_rng(game->seed, level);
+}
+
+#if ADAPTIVE_CAPACITY
+// Pool bytes for 'enemies' enemy slots and twice as many bullet slots
+// (each byte array may pick up a byte of arena alignment)
+#define BULLETS_FOR(n) ((n) * 2 < MAX_BULLETS ? (n) * 2 : MAX_BULLETS)
+#define POOL_BYTES(n) ((n) * (2 * sizeof(coord_t) + 1) + 1 + \
+                       POOL_LANES(BULLETS_FOR(n)) * 2 * (sizeof(coord_t) + sizeof(coord_delta_t)))
+
+// The most the level arena can hold at once: the sight cache, the
+// compiled walls and the pools at their ceilings. A bigger card has
+// nothing more to give the game.
+#if LEVEL_COMPILED
+#define LEVEL_ARENA_NEED (sizeof(RoomSight) + LEVEL_WALL_RAM + 1 + POOL_BYTES(MAX_ENEMIES))
+#else
+#define LEVEL_ARENA_NEED (sizeof(RoomSight) + POOL_BYTES(MAX_ENEMIES))
+#endif
+STATIC_ASSERT(LEVEL_ARENA_NEED <= ARENA_LEVEL_SIZE, adaptive_ceilings_fit_level_arena);
+
+// The least it must hold: the same, with the minimal profile's pools.
+// INIT_GAME refuses a card whose level arena is smaller.
+#define LEVEL_ARENA_MIN (LEVEL_ARENA_NEED - POOL_BYTES(MAX_ENEMIES) + POOL_BYTES(MIN_ENEMIES))
+STATIC_ASSERT(BULLETS_FOR(MIN_ENEMIES) >= MIN_BULLETS, adaptive_floor_has_minimal_bullets);
+
+// The most enemy slots (with their bullet slots) that 'budget' bytes hold
+static int pool_slots(int budget) {
+    int n = MAX_ENEMIES;
+    
+    while (n > 0 && (int)POOL_BYTES(n) > budget) n--;
+    return n;
+}
+
+// Size the entity pools to the level arena (just released by begin_level)
+// and carve them from it. INIT_GAME checked that at least MIN_ENEMIES fit.
+static void carve_pools(GameState* game) {
+    const ArenaStats* level = sim_arena_get_stats(ARENA_LEVEL);
+    int n = pool_slots(level->size - level->used);
+    
+    game->enemy_cap = (uint8_t)n;
+    game->bullet_cap = (uint8_t)BULLETS_FOR(n);
+    
+    EnemyPool* e = &game->enemies;
+    BulletPool* b = &game->bullets;
+    int lanes = POOL_LANES(game->bullet_cap);
+    e->x = sim_arena_alloc(ARENA_LEVEL, (uint16_t)(n * sizeof(coord_t)));
+    e->y = sim_arena_alloc(ARENA_LEVEL, (uint16_t)(n * sizeof(coord_t)));
+    e->health = sim_arena_alloc(ARENA_LEVEL, (uint16_t)n);
+    b->x = sim_arena_alloc(ARENA_LEVEL, (uint16_t)(lanes * sizeof(coord_t)));
+    b->y = sim_arena_alloc(ARENA_LEVEL, (uint16_t)(lanes * sizeof(coord_t)));
+    b->dx = sim_arena_alloc(ARENA_LEVEL, (uint16_t)(lanes * sizeof(coord_delta_t)));
+    b->dy = sim_arena_alloc(ARENA_LEVEL, (uint16_t)(lanes * sizeof(coord_delta_t)));
+    
+    // Arena memory is not cleared on release
+    e->live = 0;
+    e->idle = 0;
+    e->coarse = 0;
+    e->dormant = 0;
+    memset(e->wake, 0, sizeof(e->wake));
+    b->live = 0;
+    if (lanes) {
+        memset(b->x, 0, lanes * sizeof(coord_t));
+        memset(b->y, 0, lanes * sizeof(coord_t));
+        memset(b->dx, 0, lanes * sizeof(coord_delta_t));
+        memset(b->dy, 0, lanes * sizeof(coord_delta_t));
+    }
+}
+#endif
+
+// Book enemy 'i' to act 'wait' ticks (1 to ENEMY_WHEEL_SLOTS) after the
+// current tick
+static void enemy_schedule(GameState* game, int i, uint8_t wait) {
+    game->enemies.wake[ENEMY_WHEEL_SLOT(game->frame_count + wait)] |= SLOT_BIT(EnemyMask, i);
+}
+
+// Ticks until enemy 'i' next acts (0 if it is not booked)
+uint8_t enemy_wait(const GameState* game, int i) {
+    for (uint8_t wait = 1; wait <= ENEMY_WHEEL_SLOTS; wait++) {
+        if (game->enemies.wake[ENEMY_WHEEL_SLOT(game->frame_count + wait)] & SLOT_BIT(EnemyMask, i)) {
+            return wait;
+        }
+    }
+    return 0;
+}
+
+// Walk the tile grid from (x, y) along (dx, dy) with an integer DDA (any
+// direction; components up to FP_SCALE) for at most 'range' tiles. Stops
+// at the first tile that blocks a shot or sight line, or that holds an
+// enemy in 'targets' ('*hit' gets its slot, otherwise -1). Returns the
+// number of open tiles entered.
+static int walk_tiles(const GameState* game, coord_t x, coord_t y,
+                      coord_delta_t dx, coord_delta_t dy, int range,
+                      EnemyMask targets, int* hit) {
+    const EnemyPool* e = &game->enemies;
+    int tx = COORD_TILE(x), ty = COORD_TILE(y);
+    int step_x = dx > 0 ? 1 : -1, step_y = dy > 0 ? 1 : -1;
+    int32_t adx = dx < 0 ? -dx : dx, ady = dy < 0 ? -dy : dy;
+    int n, i;
+    
+    *hit = -1;
+    if (adx == 0 && ady == 0) return 0;
+    
+    // Distance (in 1/FP_SCALE tiles) to the next tile edge on each axis.
+    // The edge crossed first is the one with the smaller edge / speed,
+    // compared as edge_x * ady < edge_y * adx to stay in integers.
+    int32_t fx = x & (FP_SCALE - 1), fy = y & (FP_SCALE - 1);
+    int32_t edge_x = dx > 0 ? FP_SCALE - fx : fx;
+    int32_t edge_y = dy > 0 ? FP_SCALE - fy : fy;
+    
+    for (n = 0; n < range; n++) {
+        if (ady == 0 || (adx != 0 && edge_x * ady < edge_y * adx)) {
+            tx += step_x;
+            edge_x += FP_SCALE;
+        } else {
+            ty += step_y;
+            edge_y += FP_SCALE;
+        }
+        
+        if (tx < 0 || tx >= MAP_W || ty < 0 || ty >= MAP_H) return n;
+        uint8_t tile = map_tile(game, tx, ty);
+        if (tile == TILE_WALL || tile == TILE_DOOR) return n;
+        
+        FOR_EACH_LIVE(EnemyMask, targets, i) {
+            if (COORD_TILE(e->x[i]) == tx && COORD_TILE(e->y[i]) == ty) {
+                *hit = i;
+                return n + 1;
+            }
+        }
+    }
+    return n;
+}
+
+// Trace a shot from (x, y) along (dx, dy) for up to 'range' tiles. Returns
+// the slot of the first live enemy in its path, or -1 if a wall, closed
+// door or the range stops it first.
+int trace_shot(const GameState* game, coord_t x, coord_t y,
+               coord_delta_t dx, coord_delta_t dy, int range) {
+    const EnemyPool* e = &game->enemies;
+    int tx = COORD_TILE(x), ty = COORD_TILE(y);
+    EnemyMask ahead = 0;
+    int i, hit;
+    
+    // Only enemies on the side the shot travels towards can be hit
+    FOR_EACH_LIVE(EnemyMask, e->live, i) {
+        int ex = COORD_TILE(e->x[i]) - tx, ey = COORD_TILE(e->y[i]) - ty;
+        if (ex * dx >= 0 && ey * dy >= 0) ahead |= SLOT_BIT(EnemyMask, i);
+    }
+    
+    walk_tiles(game, x, y, dx, dy, range, ahead, &hit);
+    return hit;
+}
+
+// Noise and sight. Rooms are the regions: noise spreads from the room it
+// is made in along corridors (corridor i joins rooms i and i+1; a closed
+// door stops it), one room per hop. A room sees another if the line between
+// their centres is clear. Idle enemies in a room the noise reaches, or that
+// the player's room sees, are alerted and start taking turns. Compiled
+// levels do the same with their regions, doors and anchor tiles.
+#define NOISE_PICKUP_HOPS  0
+#define NOISE_DOOR_HOPS    1
+#define NOISE_SHOT_HOPS    2
+
+#if LEVEL_COMPILED
+// Index of the region containing floor tile (x, y), or -1
+static int room_at(const GameState* game, int x, int y) {
+    const uint8_t* blob = LEVEL_BLOB(game);
+    const uint8_t* r = level_blob_section(blob, LEVEL_BLOB_RECTS);
     
-    // Create walls (border + some interior)
-    for (int i = 0; i < MAP_W; i++) {
-        game->map[0][i] = TILE_WALL;
-        game->map[MAP_H-1][i] = TILE_WALL;
+    for (int i = 0; i < blob[LB_RECTS]; i++, r += 5) {
+        if (x >= r[0] && x < r[0] + r[2] && y >= r[1] && y < r[1] + r[3]) return r[4];
     }
-    for (int i = 0; i < MAP_H; i++) {
-        game->map[i][0] = TILE_WALL;
-        game->map[i][MAP_W-1] = TILE_WALL;
+    return -1;
+}
+
+// Regions tile (x, y) is part of: its region, or both sides of its door
+static RoomMask rooms_at(const GameState* game, int x, int y) {
+    const LevelDesc* L = &game->layout;
+    const uint8_t* joins = level_blob_section(LEVEL_BLOB(game), LEVEL_BLOB_JOINS);
+    int i;
+    
+    if (!L->room_count) return 0;
+    for (i = 0; i < L->door_count; i++) {
+        if (L->doors[i].x == x && L->doors[i].y == y) {
+            return (RoomMask)(SLOT_BIT(RoomMask, joins[2 * i]) | SLOT_BIT(RoomMask, joins[2 * i + 1]));
+        }
     }
+    i = room_at(game, x, y);
+    return i >= 0 ? SLOT_BIT(RoomMask, i) : 0;
+}
+
+// Spread 'rooms' 'hops' doors further, through open doors
+static RoomMask noise_spread(const GameState* game, RoomMask rooms, int hops) {
+    const LevelDesc* L = &game->layout;
+    const uint8_t* joins = level_blob_section(LEVEL_BLOB(game), LEVEL_BLOB_JOINS);
     
-    // Add some interior walls based on level
-    if (level == 1) {
-        // Simple cross pattern
-        for (int i = 8; i < 24; i++) {
-            game->map[MAP_H/2][i] = TILE_WALL;
-            game->map[i][MAP_W/2] = TILE_WALL;
+    while (hops-- > 0) {
+        RoomMask heard = rooms;
+        for (int i = 0; i < L->door_count; i++) {
+            RoomMask sides = (RoomMask)(SLOT_BIT(RoomMask, joins[2 * i]) | SLOT_BIT(RoomMask, joins[2 * i + 1]));
+            if ((game->doors_open & SLOT_BIT(DoorMask, i)) && (rooms & sides)) heard |= sides;
         }
+        rooms = heard;
     }
+    return rooms;
+}
+
+// Trace the sight line between the anchor tiles of regions 'a' and 'b'
+static bool rooms_trace(const GameState* game, int a, int b) {
+    const uint8_t* anchors = level_blob_section(LEVEL_BLOB(game), LEVEL_BLOB_ANCHORS);
+    int ax = anchors[2 * a], ay = anchors[2 * a + 1];
+    int dx = anchors[2 * b] - ax, dy = anchors[2 * b + 1] - ay;
+    int steps = (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy);
+    int hit;
     
-    // Place exit
-    game->map[MAP_H-2][MAP_W-2] = TILE_EXIT;
+    return walk_tiles(game, (coord_t)(TILE_COORD(ax) + FP_HALF), (coord_t)(TILE_COORD(ay) + FP_HALF),
+                      (coord_delta_t)dx, (coord_delta_t)dy, steps, 0, &hit) == steps;
+}
+#else
+// Index of the room containing tile (x, y), or -1
+static int room_at(const GameState* game, int x, int y) {
+    const LevelDesc* L = &game->layout;
     
-    // Place some pickups
-    game->map[5][5] = TILE_AMMO;
-    game->map[MAP_H-5][5] = TILE_HEALTH;
-    game->map[5][MAP_W-5] = TILE_AMMO;
+    for (int i = 0; i < L->room_count; i++) {
+        if (room_contains(&L->rooms[i], x, y)) return i;
+    }
+    return -1;
+}
+
+// Rooms tile (x, y) is part of: its room, or both ends of its corridor
+static RoomMask rooms_at(const GameState* game, int x, int y) {
+    const LevelDesc* L = &game->layout;
+    int i = room_at(game, x, y);
     
-    // Place player
-    game->player_x = 2 * FP_SCALE;
-    game->player_y = 2 * FP_SCALE;
+    if (i >= 0) return SLOT_BIT(RoomMask, i);
+    for (i = 0; i < L->room_count - 1; i++) {
+        if (corridor_contains(L, i, x, y)) return (RoomMask)(SLOT_BIT(RoomMask, i) | SLOT_BIT(RoomMask, i + 1));
+    }
+    return 0;
+}
+
+// Spread 'rooms' 'hops' corridors further, through open doorways
+static RoomMask noise_spread(const GameState* game, RoomMask rooms, int hops) {
+    const LevelDesc* L = &game->layout;
+    
+    while (hops-- > 0) {
+        RoomMask heard = rooms;
+        for (int i = 0; i < L->room_count - 1; i++) {
+            bool open = L->doors[i].x == 0 || (game->doors_open & SLOT_BIT(DoorMask, i));
+            if (open && (rooms & (RoomMask)(SLOT_BIT(RoomMask, i) | SLOT_BIT(RoomMask, i + 1)))) {
+                heard |= (RoomMask)(SLOT_BIT(RoomMask, i) | SLOT_BIT(RoomMask, i + 1));
+            }
+        }
+        rooms = heard;
+    }
+    return rooms;
+}
+
+// Trace the sight line between the centres of rooms 'a' and 'b'
+static bool rooms_trace(const GameState* game, int a, int b) {
+    const LevelRoom* ra = &game->layout.rooms[a];
+    const LevelRoom* rb = &game->layout.rooms[b];
+    int dx = ROOM_CX(rb) - ROOM_CX(ra), dy = ROOM_CY(rb) - ROOM_CY(ra);
+    int steps = (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy);
+    int hit;
+    
+    return walk_tiles(game, (coord_t)(TILE_COORD(ROOM_CX(ra)) + FP_HALF),
+                      (coord_t)(TILE_COORD(ROOM_CY(ra)) + FP_HALF),
+                      (coord_delta_t)dx, (coord_delta_t)dy, steps, 0, &hit) == steps;
+}
+
+#endif
+
+// Whether room 'a' sees room 'b', from the cache when it has the pair
+bool rooms_see(const GameState* game, int a, int b) {
+    if (a == b) return true;
+    if (a > b) { int t = a; a = b; b = t; }    // Trace each pair one way only
+    if (!room_sight) return rooms_trace(game, a, b);
+    
+    if (!(room_sight->known[a] & SLOT_BIT(RoomMask, b))) {
+        room_sight->known[a] |= SLOT_BIT(RoomMask, b);
+        if (rooms_trace(game, a, b)) room_sight->clear[a] |= SLOT_BIT(RoomMask, b);
+    }
+    return (room_sight->clear[a] & SLOT_BIT(RoomMask, b)) != 0;
+}
+
+// Start enemy 'i' taking turns
+static void enemy_alert(GameState* game, int i) {
+    game->enemies.idle &= (EnemyMask)~SLOT_BIT(EnemyMask, i);
+    enemy_schedule(game, i, ENEMY_SPEED);
+}
+
+// Alert the idle enemies standing in 'rooms'. Idle enemies never move, so
+// each is still in the room it spawned in.
+static void alert_rooms(GameState* game, RoomMask rooms) {
+    EnemyPool* e = &game->enemies;
+    EnemyMask idle = e->idle & e->live;
+    int i;
+    
+    if (!rooms) return;
+    FOR_EACH_LIVE(EnemyMask, idle, i) {
+        int r = room_at(game, COORD_TILE(e->x[i]), COORD_TILE(e->y[i]));
+        if (r >= 0 && (rooms & SLOT_BIT(RoomMask, r))) enemy_alert(game, i);
+    }
+}
+
+// A noise at tile (x, y) that carries 'hops' corridors
+static void make_noise(GameState* game, int x, int y, int hops) {
+    if (!(game->enemies.idle & game->enemies.live)) return;
+    alert_rooms(game, noise_spread(game, rooms_at(game, x, y), hops));
+}
+
+// Alert idle enemies in rooms the player's room (or corridor ends) can see.
+// Called when the player enters a new tile.
+static void alert_by_sight(GameState* game) {
+    const LevelDesc* L = &game->layout;
+    RoomMask from = rooms_at(game, COORD_TILE(game->player_x), COORD_TILE(game->player_y));
+    RoomMask seen = 0;
+    int a, b;
+    
+    if (!(game->enemies.idle & game->enemies.live)) return;
+    FOR_EACH_LIVE(RoomMask, from, a) {
+        for (b = 0; b < L->room_count; b++) {
+            if (rooms_see(game, a, b)) seen |= SLOT_BIT(RoomMask, b);
+        }
+    }
+    alert_rooms(game, seen);
+}
+
+// Place the player and the level's enemies
+#if LEVEL_COMPILED
+static void spawn_level_entities(GameState* game) {
+    const uint8_t* blob = LEVEL_BLOB(game);
+    int rooms = game->layout.room_count;
+    
+    game->player_x = TILE_COORD(blob[LB_PLAYER]);
+    game->player_y = TILE_COORD(blob[LB_PLAYER + 1]);
     game->player_angle = DIR_EAST;
     
-    // Reset entities
-    for (int i = 0; i < MAX_ENEMIES; i++) {
-        game->enemies[i].active = false;
+    // The sight cache comes first, filled in from the blob when it has
+    // the sight lines (they hold until a door opens)
+    room_sight = sim_arena_alloc(ARENA_LEVEL, sizeof(RoomSight));
+    if (room_sight) {
+        memset(room_sight, 0, sizeof(RoomSight));
+        if (blob[LB_FLAGS] & LEVEL_BLOB_SIGHT) {
+            const uint8_t* sight = level_blob_section(blob, LEVEL_BLOB_SIGHTS);
+            for (int a = 0; a < rooms; a++) {
+                room_sight->known[a] = (RoomMask)(SLOTS_ALL(RoomMask, rooms) & ~SLOTS_ALL(RoomMask, a + 1));
+                room_sight->clear[a] = (RoomMask)((sight[2 * a] << 8 | sight[2 * a + 1]) & room_sight->known[a]);
+            }
+        }
     }
-    for (int i = 0; i < MAX_BULLETS; i++) {
-        game->bullets[i].active = false;
+    
+#if ADAPTIVE_CAPACITY
+    carve_pools(game);
+#else
+    memset(&game->enemies, 0, sizeof(game->enemies));
+    memset(&game->bullets, 0, sizeof(game->bullets));
+#endif
+    
+    // Enemies stand where the map put them. Without nav data nothing
+    // could alert them, so they start awake.
+    const uint8_t* spawns = level_blob_section(blob, LEVEL_BLOB_SPAWNS);
+    int enemy_count = blob[LB_SPAWNS];
+    if (enemy_count > ENEMY_CAP(game)) enemy_count = ENEMY_CAP(game);
+    
+    EnemyPool* e = &game->enemies;
+    for (int i = 0; i < enemy_count; i++) {
+        e->live |= SLOT_BIT(EnemyMask, i);
+        e->health[i] = 2;
+        e->x[i] = TILE_COORD(spawns[2 * i]);
+        e->y[i] = TILE_COORD(spawns[2 * i + 1]);
+        if (rooms) e->idle |= SLOT_BIT(EnemyMask, i);
+        else enemy_schedule(game, i, ENEMY_SPEED);
     }
+}
+#else
+static void spawn_level_entities(GameState* game) {
+    // Place player in the centre of the first room
+    const LevelRoom* start = &game->layout.rooms[0];
+    game->player_x = TILE_COORD(ROOM_CX(start));
+    game->player_y = TILE_COORD(ROOM_CY(start));
+    game->player_angle = DIR_EAST;
     
-    // Spawn enemies based on level
-    int enemy_count = 2 + level;
-    if (enemy_count > MAX_ENEMIES) enemy_count = MAX_ENEMIES;
+    // The sight cache comes first: adaptive pools take what is left
+    room_sight = sim_arena_alloc(ARENA_LEVEL, sizeof(RoomSight));
+    if (room_sight) memset(room_sight, 0, sizeof(RoomSight));
     
+    // Reset entities (free bullet slots must carry zero velocity)
+#if ADAPTIVE_CAPACITY
+    carve_pools(game);
+#else
+    memset(&game->enemies, 0, sizeof(game->enemies));
+    memset(&game->bullets, 0, sizeof(game->bullets));
+#endif
+    
+    // Spawn enemies based on level, spread over every room but the first
+    int enemy_count = 2 + game->level;
+    if (enemy_count > ENEMY_CAP(game)) enemy_count = ENEMY_CAP(game);
+    
+    EnemyPool* e = &game->enemies;
     for (int i = 0; i < enemy_count; i++) {
-        game->enemies[i].active = true;
-        game->enemies[i].health = 2;
-        game->enemies[i].move_timer = 0;
-        // Place enemies in different quadrants
-        switch (i % 4) {
-            case 0: game->enemies[i].x = 25 * FP_SCALE; game->enemies[i].y = 5 * FP_SCALE; break;
-            case 1: game->enemies[i].x = 5 * FP_SCALE; game->enemies[i].y = 25 * FP_SCALE; break;
-            case 2: game->enemies[i].x = 25 * FP_SCALE; game->enemies[i].y = 25 * FP_SCALE; break;
-            case 3: game->enemies[i].x = 15 * FP_SCALE; game->enemies[i].y = 15 * FP_SCALE; break;
-        }
+        const LevelRoom* r = &game->layout.rooms[1 + i % (game->layout.room_count - 1)];
+        e->live |= SLOT_BIT(EnemyMask, i);
+        e->idle |= SLOT_BIT(EnemyMask, i);
+        e->health[i] = 2;
+        e->x[i] = TILE_COORD(r->x + level_rand_below(&game->build_rng, r->w));
+        e->y[i] = TILE_COORD(r->y + level_rand_below(&game->build_rng, r->h));
+    }
+}
+#endif
+
+// Run the next slice of the level build: one stage, or LEVEL_BAKE_CHUNKS
+// chunks of a streamed map. Returns true once the level is playable.
+bool level_build_step(GameState* game) {
+    switch (game->build_stage) {
+        case LEVEL_STAGE_LAYOUT:
+#if LEVEL_COMPILED
+            if (!load_level(game)) game->game_over = true;
+#else
+            generate_level(game, game->level, &game->build_rng);
+#endif
+            game->pickups_taken = 0;
+            game->doors_open = 0;
+            game->build_stage = LEVEL_STAGE_SPAWN;
+            break;
+        case LEVEL_STAGE_SPAWN:
+            spawn_level_entities(game);
+            game->build_stage = MAP_STREAMED ? LEVEL_STAGE_BAKE : LEVEL_STAGE_READY;
+            break;
+#if MAP_STREAMED
+        case LEVEL_STAGE_BAKE:
+            game->build_pos = map_stream_bake(game, game->build_pos, LEVEL_BAKE_CHUNKS);
+            if (game->build_pos == MAP_CHUNK_COUNT) game->build_stage = LEVEL_STAGE_READY;
+            break;
+#endif
+    }
+    if (game->build_stage != LEVEL_STAGE_READY) return false;
+    
+    // Anyone in sight of the start room is alerted as the level opens
+    alert_by_sight(game);
+    return true;
+}
+
+// Level build progress, 0-100
+uint8_t level_build_progress(const GameState* game) {
+    switch (game->build_stage) {
+        case LEVEL_STAGE_LAYOUT: return 0;
+        case LEVEL_STAGE_SPAWN:  return 5;
+#if MAP_STREAMED
+        case LEVEL_STAGE_BAKE:   return (uint8_t)(10 + 90L * game->build_pos / MAP_CHUNK_COUNT);
+#endif
+        default:                 return 100;
     }
 }
 
+// Build a whole level at once (new games and save-state loads)
+void init_level(GameState* game, uint8_t level) {
+    begin_level(game, level);
+    while (!level_build_step(game)) {}
+}
+
 // Check collision with map
-bool check_collision(GameState* game, int16_t x, int16_t y) {
-    int tile_x = x / FP_SCALE;
-    int tile_y = y / FP_SCALE;
+bool check_collision(GameState* game, coord_t x, coord_t y) {
+    int tile_x = COORD_TILE(x);
+    int tile_y = COORD_TILE(y);
     
     if (tile_x < 0 || tile_x >= MAP_W || tile_y < 0 || tile_y >= MAP_H) {
         return true;  // Out of bounds
     }
     
-    return game->map[tile_y][tile_x] == TILE_WALL;
+    uint8_t tile = map_tile(game, tile_x, tile_y);
+    return tile == TILE_WALL || tile == TILE_DOOR;
 }
 
 // Move player
@@ -176,7 +1346,7 @@ void move_player(GameState* game, int8_t forward, int8_t strafe) {
     if (game->game_over) return;
     
     // Calculate movement vector
-    int16_t dx = 0, dy = 0;
+    coord_delta_t dx = 0, dy = 0;
     
     if (forward != 0) {
         switch (game->player_angle) {
@@ -197,32 +1367,53 @@ void move_player(GameState* game, int8_t forward, int8_t strafe) {
     }
     
     // Check collision and move
-    int16_t new_x = game->player_x + dx;
-    int16_t new_y = game->player_y + dy;
+    coord_t new_x = (coord_t)(game->player_x + dx);
+    coord_t new_y = (coord_t)(game->player_y + dy);
+    
+    // Walking into a closed door opens it (the player stays put this tick)
+    int door = level_door_at(game, COORD_TILE(new_x), COORD_TILE(new_y));
+    if (door >= 0) {
+        game->doors_open |= SLOT_BIT(DoorMask, door);
+        reset_room_sight();   // Sight lines may open up
+        make_noise(game, COORD_TILE(new_x), COORD_TILE(new_y), NOISE_DOOR_HOPS);
+        return;
+    }
     
     if (!check_collision(game, new_x, new_y)) {
+        bool new_tile = COORD_TILE(new_x) != COORD_TILE(game->player_x) ||
+                        COORD_TILE(new_y) != COORD_TILE(game->player_y);
         game->player_x = new_x;
         game->player_y = new_y;
         
         // Check for pickups
-        int tile_x = new_x / FP_SCALE;
-        int tile_y = new_y / FP_SCALE;
-        uint8_t tile = game->map[tile_y][tile_x];
+        int tile_x = COORD_TILE(new_x);
+        int tile_y = COORD_TILE(new_y);
+        int pickup = level_pickup_at(game, tile_x, tile_y);
+        uint8_t tile = map_tile(game, tile_x, tile_y);
+        
+        if (new_tile) alert_by_sight(game);
         
         switch (tile) {
             case TILE_AMMO:
                 game->ammo += 10;
                 if (game->ammo > 99) game->ammo = 99;
-                game->map[tile_y][tile_x] = TILE_EMPTY;
+                game->pickups_taken |= SLOT_BIT(PickupMask, pickup);
+                make_noise(game, tile_x, tile_y, NOISE_PICKUP_HOPS);
                 break;
             case TILE_HEALTH:
                 game->health += 25;
                 if (game->health > 100) game->health = 100;
-                game->map[tile_y][tile_x] = TILE_EMPTY;
+                game->pickups_taken |= SLOT_BIT(PickupMask, pickup);
+                make_noise(game, tile_x, tile_y, NOISE_PICKUP_HOPS);
                 break;
             case TILE_EXIT:
-                game->victory = true;
-                game->game_over = true;
+                if (game->level < LEVEL_COUNT) {
+                    // On to the next level; health and ammo carry over
+                    begin_level(game, (uint8_t)(game->level + 1));
+                } else {
+                    game->victory = true;
+                    game->game_over = true;
+                }
                 break;
         }
     }
@@ -244,252 +1435,497 @@ void turn_player(GameState* game, int8_t direction) {
     }
 }
 
-// Fire bullet
+// Fire a projectile from the bullet pool
+static void fire_projectile(GameState* game) {
+    // Find free bullet slot
+    BulletPool* b = &game->bullets;
+    BulletMask free_slots = (BulletMask)(~b->live & SLOTS_ALL(BulletMask, BULLET_CAP(game)));
+    if (!free_slots) return;
+    int i = SLOT_LOWEST(free_slots);
+    
+    b->live |= SLOT_BIT(BulletMask, i);
+    b->x[i] = game->player_x;
+    b->y[i] = game->player_y;
+    
+    // Set velocity based on player direction
+    switch (game->player_angle) {
+        case DIR_NORTH: b->dx[i] = 0; b->dy[i] = -BULLET_SPEED * FP_HALF; break;
+        case DIR_EAST:  b->dx[i] = BULLET_SPEED * FP_HALF; b->dy[i] = 0; break;
+        case DIR_SOUTH: b->dx[i] = 0; b->dy[i] = BULLET_SPEED * FP_HALF; break;
+        case DIR_WEST:  b->dx[i] = -BULLET_SPEED * FP_HALF; b->dy[i] = 0; break;
+    }
+    
+    game->ammo--;
+}
+
+// Take one point of health from enemy 'i'
+static void hit_enemy(GameState* game, int i) {
+    EnemyPool* e = &game->enemies;
+    
+    e->health[i]--;
+    if (e->health[i] == 0) {
+        e->live &= (EnemyMask)~SLOT_BIT(EnemyMask, i);
+    }
+}
+
+// Fire the current weapon
 void fire_bullet(GameState* game) {
     if (game->game_over || game->ammo == 0) return;
     
-    // Find free bullet slot
-    for (int i = 0; i < MAX_BULLETS; i++) {
-        if (!game->bullets[i].active) {
-            game->bullets[i].active = true;
-            game->bullets[i].x = game->player_x;
-            game->bullets[i].y = game->player_y;
-            
-            // Set velocity based on player direction
-            switch (game->player_angle) {
-                case DIR_NORTH:
-                    game->bullets[i].dx = 0;
-                    game->bullets[i].dy = -BULLET_SPEED * FP_HALF;
-                    break;
-                case DIR_EAST:
-                    game->bullets[i].dx = BULLET_SPEED * FP_HALF;
-                    game->bullets[i].dy = 0;
-                    break;
-                case DIR_SOUTH:
-                    game->bullets[i].dx = 0;
-                    game->bullets[i].dy = BULLET_SPEED * FP_HALF;
-                    break;
-                case DIR_WEST:
-                    game->bullets[i].dx = -BULLET_SPEED * FP_HALF;
-                    game->bullets[i].dy = 0;
-                    break;
-            }
-            
-            game->ammo--;
-            break;
-        }
+    make_noise(game, COORD_TILE(game->player_x), COORD_TILE(game->player_y), NOISE_SHOT_HOPS);
+    if (!weapons[game->weapon].hitscan) {
+        fire_projectile(game);
+        return;
     }
+    
+    // Hitscan: the shot lands (or misses) now, with no bullet to track
+    coord_delta_t dx = 0, dy = 0;
+    switch (game->player_angle) {
+        case DIR_NORTH: dy = -FP_SCALE; break;
+        case DIR_EAST:  dx = FP_SCALE; break;
+        case DIR_SOUTH: dy = FP_SCALE; break;
+        case DIR_WEST:  dx = -FP_SCALE; break;
+    }
+    int target = trace_shot(game, game->player_x, game->player_y, dx, dy, weapons[game->weapon].range);
+    if (target >= 0) hit_enemy(game, target);
+    game->ammo--;
+}
+
+// Cycle to the next weapon
+void switch_weapon(GameState* game) {
+    if (game->game_over) return;
+    game->weapon = (uint8_t)((game->weapon + 1) % WEAPON_COUNT);
+}
+
+// Return a bullet slot to the pool
+static void retire_bullet(BulletPool* b, int i) {
+    b->live &= (BulletMask)~SLOT_BIT(BulletMask, i);
+    b->dx[i] = 0;
+    b->dy[i] = 0;
 }
 
 // Update bullets
 void update_bullets(GameState* game) {
-    for (int i = 0; i < MAX_BULLETS; i++) {
-        if (!game->bullets[i].active) continue;
-        
-        // Move bullet
-        game->bullets[i].x += game->bullets[i].dx;
-        game->bullets[i].y += game->bullets[i].dy;
-        
+    BulletPool* b = &game->bullets;
+    EnemyPool* e = &game->enemies;
+    int i, j;
+    
+    if (!b->live) return;
+    
+    // Move bullets
+#if DENSE_ENTITY_KERNELS
+    // Every slot, no branches: free slots have zero velocity and stay put
+    for (i = 0; i < POOL_LANES(BULLET_CAP(game)); i++) {
+        b->x[i] += b->dx[i];
+        b->y[i] += b->dy[i];
+    }
+#else
+    FOR_EACH_LIVE(BulletMask, b->live, i) {
+        b->x[i] += b->dx[i];
+        b->y[i] += b->dy[i];
+    }
+#endif
+    
+    FOR_EACH_LIVE(BulletMask, b->live, i) {
         // Check wall collision
-        if (check_collision(game, game->bullets[i].x, game->bullets[i].y)) {
-            game->bullets[i].active = false;
+        if (check_collision(game, b->x[i], b->y[i])) {
+            retire_bullet(b, i);
             continue;
         }
         
         // Check enemy collision
-        int bx = game->bullets[i].x / FP_SCALE;
-        int by = game->bullets[i].y / FP_SCALE;
+        int bx = COORD_TILE(b->x[i]);
+        int by = COORD_TILE(b->y[i]);
         
-        for (int j = 0; j < MAX_ENEMIES; j++) {
-            if (!game->enemies[j].active) continue;
-            
-            int ex = game->enemies[j].x / FP_SCALE;
-            int ey = game->enemies[j].y / FP_SCALE;
+        FOR_EACH_LIVE(EnemyMask, e->live, j) {
+            int ex = COORD_TILE(e->x[j]);
+            int ey = COORD_TILE(e->y[j]);
             
             if (bx == ex && by == ey) {
                 // Hit!
-                game->enemies[j].health--;
-                game->bullets[i].active = false;
-                
-                if (game->enemies[j].health == 0) {
-                    game->enemies[j].active = false;
-                }
+                hit_enemy(game, j);
+                retire_bullet(b, i);
                 break;
             }
         }
     }
 }
 
-// Simple enemy AI
-void update_enemies(GameState* game) {
-    for (int i = 0; i < MAX_ENEMIES; i++) {
-        if (!game->enemies[i].active) continue;
-        
-        game->enemies[i].move_timer++;
-        if (game->enemies[i].move_timer < ENEMY_SPEED) continue;
-        game->enemies[i].move_timer = 0;
+// Contact: an enemy on the player's tile hurts
+static void enemy_contact(GameState* game, int i) {
+    const EnemyPool* e = &game->enemies;
+    
+    if (COORD_TILE(e->x[i]) != COORD_TILE(game->player_x) ||
+        COORD_TILE(e->y[i]) != COORD_TILE(game->player_y)) return;
+    
+    if (game->health > 10) {
+        game->health -= 10;
+    } else {
+        game->health = 0;
+        game->game_over = true;
+    }
+}
+
+// One chase turn for enemy 'i': a step towards the player, then contact
+static void enemy_turn(GameState* game, int i) {
+    EnemyPool* e = &game->enemies;
+    
+    // Move towards player
+    coord_delta_t dx = 0, dy = 0;
+    
+    if (e->x[i] < game->player_x) dx = FP_HALF;
+    else if (e->x[i] > game->player_x) dx = -FP_HALF;
+    
+    if (e->y[i] < game->player_y) dy = FP_HALF;
+    else if (e->y[i] > game->player_y) dy = -FP_HALF;
+    
+    // Try to move
+    coord_t new_x = (coord_t)(e->x[i] + dx);
+    coord_t new_y = (coord_t)(e->y[i] + dy);
+    
+    if (!check_collision(game, new_x, new_y)) {
+        e->x[i] = new_x;
+        e->y[i] = new_y;
+    }
+    
+    enemy_contact(game, i);
+}
+
+// Tiles a move of (dx, dy) from (x, y) crosses, one axis at a time
+static int move_tiles(coord_t x, coord_t y, int32_t dx, int32_t dy) {
+    int tx = COORD_TILE((int32_t)x + dx) - COORD_TILE(x);
+    int ty = COORD_TILE((int32_t)y + dy) - COORD_TILE(y);
+    
+    return (tx < 0 ? -tx : tx) + (ty < 0 ? -ty : ty);
+}
+
+// 'turns' chase turns for enemy 'i' in closed form. Each turn closes half a
+// tile on each axis, so together they close min(turns half tiles, the gap)
+// per axis. Walls clamp the move: the enemy goes as far along the straight
+// line as it can in steps of one tile crossed, checking each with
+// walk_tiles(), so it never ends in or beyond a wall.
+static void enemy_catch_up(GameState* game, int i, int turns) {
+    EnemyPool* e = &game->enemies;
+    int32_t reach = (int32_t)turns * FP_HALF;
+    int32_t dx = (int32_t)game->player_x - e->x[i];
+    int32_t dy = (int32_t)game->player_y - e->y[i];
+    int32_t mx = 0, my = 0;
+    int tiles, hit;
+    
+    if (dx > reach) dx = reach;
+    else if (dx < -reach) dx = -reach;
+    if (dy > reach) dy = reach;
+    else if (dy < -reach) dy = -reach;
+    
+    // At most 2 * turns lines to try, each a walk of as many tiles
+    tiles = move_tiles(e->x[i], e->y[i], dx, dy);
+    if (tiles == 0) {
+        mx = dx;        // Stays on its own tile
+        my = dy;
+    }
+    for (int k = tiles; k > 0; k--) {
+        int32_t sx = dx * k / tiles, sy = dy * k / tiles;
+        int n = move_tiles(e->x[i], e->y[i], sx, sy);
         
-        // Move towards player
-        int16_t dx = 0, dy = 0;
+        if (walk_tiles(game, e->x[i], e->y[i], (coord_delta_t)sx, (coord_delta_t)sy, n, 0, &hit) == n) {
+            mx = sx;
+            my = sy;
+            break;
+        }
+    }
+    e->x[i] = (coord_t)(e->x[i] + mx);
+    e->y[i] = (coord_t)(e->y[i] + my);
+    
+    enemy_contact(game, i);
+}
+
+// Whether enemy 'i' is within 'bx' by 'by' tiles of the player
+static bool enemy_within(const GameState* game, int i, int bx, int by) {
+    int dx = COORD_TILE(game->enemies.x[i]) - COORD_TILE(game->player_x);
+    int dy = COORD_TILE(game->enemies.y[i]) - COORD_TILE(game->player_y);
+    
+    return (dx < 0 ? -dx : dx) <= bx && (dy < 0 ? -dy : dy) <= by;
+}
+
+// Simple enemy AI, for the enemies due this tick
+void update_enemies(GameState* game) {
+    EnemyPool* e = &game->enemies;
+    uint8_t slot = ENEMY_WHEEL_SLOT(game->frame_count);
+    EnemyMask due = e->wake[slot] & e->live;   // Drops bits left by the dead
+    int i;
+    
+    e->wake[slot] = 0;
+    FOR_EACH_LIVE(EnemyMask, due, i) {
+        EnemyMask bit = SLOT_BIT(EnemyMask, i);
         
-        if (game->enemies[i].x < game->player_x) dx = FP_HALF;
-        else if (game->enemies[i].x > game->player_x) dx = -FP_HALF;
+        // Coarse enemies owe the turns of their wait; a dormant one only
+        // the last wait's, once the player is back inside the wake box
+        if (game->game_over) {
+            // An earlier enemy ended the game: nobody moves, all rebook
+        } else if (e->coarse & bit) {
+            enemy_catch_up(game, i, AI_COARSE_TURNS);
+        } else if (!(e->dormant & bit)) {
+            enemy_turn(game, i);
+        } else if (enemy_within(game, i, AI_WAKE_X, AI_WAKE_Y)) {
+            enemy_catch_up(game, i, AI_DORMANT_TURNS);
+        }
         
-        if (game->enemies[i].y < game->player_y) dy = FP_HALF;
-        else if (game->enemies[i].y > game->player_y) dy = -FP_HALF;
+        // Book the next turn at the detail the new distance calls for
+        e->coarse &= (EnemyMask)~bit;
+        e->dormant &= (EnemyMask)~bit;
+        if (enemy_within(game, i, AI_NEAR_X, AI_NEAR_Y)) {
+            enemy_schedule(game, i, ENEMY_SPEED);
+        } else if (enemy_within(game, i, AI_WAKE_X, AI_WAKE_Y)) {
+            e->coarse |= bit;
+            enemy_schedule(game, i, AI_COARSE_WAIT);
+        } else {
+            e->dormant |= bit;
+            enemy_schedule(game, i, AI_DORMANT_WAIT);
+        }
+    }
+}
+
+// Draw screen row 'sy' (VIEW_W bytes) into 'row'. Rows are independent,
+// so a caller can produce just the rows it is about to send.
+static void render_row(const GameState* game, int sy, uint8_t* row) {
+    // Viewport in locals: stores through 'row' may alias view_w/view_h, and
+    // would otherwise force a reload on every use. Card builds fold them.
+    const int w = VIEW_W, h = VIEW_H;
+    int i;
+    
+    memset(row, CHAR_EMPTY, w);
+    
+    // Nothing to draw until the level is built: show its progress instead
+    if (LEVEL_LOADING(game)) {
+        if (sy == h / 2) {
+            char msg[] = "LOADING LEVEL 00 ... 000%";
+            uint8_t pct = level_build_progress(game);
+            msg[14] = '0' + game->level / 10;
+            msg[15] = '0' + game->level % 10;
+            msg[21] = '0' + pct / 100;
+            msg[22] = '0' + (pct / 10) % 10;
+            msg[23] = '0' + pct % 10;
+            memcpy(&row[(w - (int)(sizeof(msg) - 1)) / 2], msg, sizeof(msg) - 1);
+        }
+        return;
+    }
+    
+    // Status line (manual formatting for SIM compatibility)
+    if (sy == h - 2) {
+        const char* hp_label = "HP:";
+        const char* am_label = " AM:";
+        const char* lv_label = " L:";
+        const char* weapon = weapons[game->weapon].name;
+        int pos = 0;
         
-        // Try to move
-        int16_t new_x = game->enemies[i].x + dx;
-        int16_t new_y = game->enemies[i].y + dy;
+        // HP
+        for (i = 0; hp_label[i]; i++) row[pos++] = hp_label[i];
+        row[pos++] = '0' + (game->health / 100);
+        row[pos++] = '0' + ((game->health / 10) % 10);
+        row[pos++] = '0' + (game->health % 10);
         
-        if (!check_collision(game, new_x, new_y)) {
-            game->enemies[i].x = new_x;
-            game->enemies[i].y = new_y;
-        }
+        // AM
+        for (i = 0; am_label[i]; i++) row[pos++] = am_label[i];
+        row[pos++] = '0' + (game->ammo / 10);
+        row[pos++] = '0' + (game->ammo % 10);
         
-        // Check if enemy reached player
-        int ex = game->enemies[i].x / FP_SCALE;
-        int ey = game->enemies[i].y / FP_SCALE;
-        int px = game->player_x / FP_SCALE;
-        int py = game->player_y / FP_SCALE;
+        // Level
+        for (i = 0; lv_label[i]; i++) row[pos++] = lv_label[i];
+        if (game->level >= 10) row[pos++] = '0' + game->level / 10;
+        row[pos++] = '0' + game->level % 10;
         
-        if (ex == px && ey == py) {
-            // Damage player
-            if (game->health > 10) {
-                game->health -= 10;
-            } else {
-                game->health = 0;
-                game->game_over = true;
+        // Weapon
+        row[pos++] = ' ';
+        for (i = 0; weapon[i]; i++) row[pos++] = weapon[i];
+        return;
+    }
+    
+    // Message line
+    if (sy == h - 1) {
+        if (game->game_over) {
+            const char* msg = game->victory ? "VICTORY! You found the exit!" : "GAME OVER - You died!";
+            int len = strlen(msg);
+            int start = (w - len) / 2;
+            for (i = 0; i < len && start + i < w; i++) {
+                row[start + i] = msg[i];
+            }
+        } else {
+            const char* help = "WASD=move QE=turn SPC=fire F=weapon";
+            for (i = 0; help[i] && i < w; i++) {
+                row[i] = help[i];
             }
         }
+        return;
     }
-}
-
-// Render game to text screen
-void render_game(GameState* game) {
-    // Clear screen
-    memset(game->screen, CHAR_EMPTY, sizeof(game->screen));
     
-    // Draw visible portion of map (centered on player)
-    int px = game->player_x / FP_SCALE;
-    int py = game->player_y / FP_SCALE;
+    // Visible portion of map (centered on player)
+    int view_x = COORD_TILE(game->player_x) - w / 2;
+    int my = COORD_TILE(game->player_y) - (h - 3) / 2 + sy;  // Leave room for status
     
-    int view_x = px - SCREEN_W / 2;
-    int view_y = py - (SCREEN_H - 3) / 2;  // Leave room for status
-    
-    for (int sy = 0; sy < SCREEN_H - 2; sy++) {
-        for (int sx = 0; sx < SCREEN_W; sx++) {
+    if (my >= 0 && my < MAP_H) {
+        for (int sx = 0; sx < w; sx++) {
             int mx = view_x + sx;
-            int my = view_y + sy;
+            if (mx < 0 || mx >= MAP_W) continue;   // Out of bounds
             
-            if (mx >= 0 && mx < MAP_W && my >= 0 && my < MAP_H) {
-                switch (game->map[my][mx]) {
-                    case TILE_WALL:   game->screen[sy][sx] = CHAR_WALL; break;
-                    case TILE_EXIT:   game->screen[sy][sx] = CHAR_EXIT; break;
-                    case TILE_AMMO:   game->screen[sy][sx] = CHAR_AMMO; break;
-                    case TILE_HEALTH: game->screen[sy][sx] = CHAR_HEALTH; break;
-                    default:          game->screen[sy][sx] = CHAR_EMPTY; break;
-                }
-            } else {
-                game->screen[sy][sx] = CHAR_EMPTY;  // Out of bounds
+            switch (map_tile(game, mx, my)) {
+                case TILE_WALL:   row[sx] = CHAR_WALL; break;
+                case TILE_DOOR:   row[sx] = CHAR_DOOR; break;
+                case TILE_EXIT:   row[sx] = CHAR_EXIT; break;
+                case TILE_AMMO:   row[sx] = CHAR_AMMO; break;
+                case TILE_HEALTH: row[sx] = CHAR_HEALTH; break;
+                default:          break;
             }
         }
     }
     
-    // Draw entities
-    for (int i = 0; i < MAX_ENEMIES; i++) {
-        if (!game->enemies[i].active) continue;
-        
-        int ex = game->enemies[i].x / FP_SCALE - view_x;
-        int ey = game->enemies[i].y / FP_SCALE - view_y;
-        
-        if (ex >= 0 && ex < SCREEN_W && ey >= 0 && ey < SCREEN_H - 2) {
-            game->screen[ey][ex] = CHAR_ENEMY;
+    // Entities on this row
+    FOR_EACH_LIVE(EnemyMask, game->enemies.live, i) {
+        int ex = COORD_TILE(game->enemies.x[i]) - view_x;
+        if (COORD_TILE(game->enemies.y[i]) == my && ex >= 0 && ex < w) {
+            row[ex] = CHAR_ENEMY;
         }
     }
     
-    // Draw bullets
-    for (int i = 0; i < MAX_BULLETS; i++) {
-        if (!game->bullets[i].active) continue;
-        
-        int bx = game->bullets[i].x / FP_SCALE - view_x;
-        int by = game->bullets[i].y / FP_SCALE - view_y;
-        
-        if (bx >= 0 && bx < SCREEN_W && by >= 0 && by < SCREEN_H - 2) {
-            game->screen[by][bx] = CHAR_BULLET;
+    // Bullets
+    FOR_EACH_LIVE(BulletMask, game->bullets.live, i) {
+        int bx = COORD_TILE(game->bullets.x[i]) - view_x;
+        if (COORD_TILE(game->bullets.y[i]) == my && bx >= 0 && bx < w) {
+            row[bx] = CHAR_BULLET;
         }
     }
     
-    // Draw player (always in center)
-    game->screen[(SCREEN_H - 3) / 2][SCREEN_W / 2] = CHAR_PLAYER;
-    
-    // Draw direction indicator
-    int dir_x = SCREEN_W / 2;
-    int dir_y = (SCREEN_H - 3) / 2;
-    switch (game->player_angle) {
-        case DIR_NORTH: if (dir_y > 0) game->screen[dir_y - 1][dir_x] = '^'; break;
-        case DIR_EAST:  if (dir_x < SCREEN_W - 1) game->screen[dir_y][dir_x + 1] = '>'; break;
-        case DIR_SOUTH: if (dir_y < SCREEN_H - 3) game->screen[dir_y + 1][dir_x] = 'v'; break;
-        case DIR_WEST:  if (dir_x > 0) game->screen[dir_y][dir_x - 1] = '<'; break;
+    // Player (always in center) and direction indicator
+    int dir_x = w / 2;
+    int dir_y = (h - 3) / 2;
+    if (sy == dir_y) {
+        row[dir_x] = CHAR_PLAYER;
+        if (game->player_angle == DIR_EAST && dir_x < w - 1) row[dir_x + 1] = '>';
+        if (game->player_angle == DIR_WEST && dir_x > 0) row[dir_x - 1] = '<';
+    } else if (sy == dir_y - 1 && game->player_angle == DIR_NORTH) {
+        row[dir_x] = '^';
+    } else if (sy == dir_y + 1 && game->player_angle == DIR_SOUTH) {
+        row[dir_x] = 'v';
     }
+}
+
+// Render screen rows [first, first + count) into 'out', VIEW_W bytes per
+// row and 'stride' bytes from one row to the next. Nothing is stored: the
+// caller's buffer (on the card, the APDU response) is the only copy of the
+// frame.
+void render_rows(const GameState* game, uint8_t* out, int stride, int first, int count) {
+#if MAP_STREAMED
+    int view_x = COORD_TILE(game->player_x) - VIEW_W / 2;
+    int view_y = COORD_TILE(game->player_y) - (VIEW_H - 3) / 2;
+#endif
     
-    // Status line (manual formatting for SIM compatibility)
-    const char* hp_label = "HP:";
-    const char* am_label = " AM:";
-    const char* lv_label = " L:";
-    int pos = 0;
-    
-    // HP
-    for (int i = 0; hp_label[i]; i++) game->screen[SCREEN_H - 2][pos++] = hp_label[i];
-    game->screen[SCREEN_H - 2][pos++] = '0' + (game->health / 100);
-    game->screen[SCREEN_H - 2][pos++] = '0' + ((game->health / 10) % 10);
-    game->screen[SCREEN_H - 2][pos++] = '0' + (game->health % 10);
-    
-    // AM  
-    for (int i = 0; am_label[i]; i++) game->screen[SCREEN_H - 2][pos++] = am_label[i];
-    game->screen[SCREEN_H - 2][pos++] = '0' + (game->ammo / 10);
-    game->screen[SCREEN_H - 2][pos++] = '0' + (game->ammo % 10);
-    
-    // Level
-    for (int i = 0; lv_label[i]; i++) game->screen[SCREEN_H - 2][pos++] = lv_label[i];
-    game->screen[SCREEN_H - 2][pos++] = '0' + game->level;
-    
-    // Message line
-    if (game->game_over) {
-        const char* msg = game->victory ? "VICTORY! You found the exit!" : "GAME OVER - You died!";
-        int len = strlen(msg);
-        int start = (SCREEN_W - len) / 2;
-        for (int i = 0; i < len && start + i < SCREEN_W; i++) {
-            game->screen[SCREEN_H - 1][start + i] = msg[i];
-        }
-    } else {
-        const char* help = "WASD=move QE=turn SPC=fire";
-        for (int i = 0; help[i] && i < SCREEN_W; i++) {
-            game->screen[SCREEN_H - 1][i] = help[i];
+    for (int sy = first; sy < first + count; sy++) {
+#if MAP_STREAMED
+        // Pull in the next band of chunks before drawing across it (not
+        // while loading: the chunks are still being baked)
+        if (!LEVEL_LOADING(game) && (sy == first || ((view_y + sy) & (MAP_CHUNK - 1)) == 0)) {
+            map_stream_prefetch(view_x, view_y + sy, view_x + VIEW_W - 1,
+                                view_y + sy + MAP_CHUNK - 1);
         }
+#endif
+        render_row(game, sy, out);
+        out += stride;
     }
 }
 
+#if RUNTIME_VIEWPORT
+// Host frames come from their own bump arena, not the card heap (a 200x60
+// frame is larger than a whole MINIMAL card). Rows are padded to a
+// FRAME_ALIGN-byte stride so each starts on a vector boundary; the arena
+// holds two full-size frames (front and back buffer).
+#define FRAME_ALIGN         16
+#define FRAME_STRIDE(w)     (((w) + FRAME_ALIGN - 1) & ~(FRAME_ALIGN - 1))
+#define FRAME_ARENA_SIZE    (2 * FRAME_STRIDE(VIEW_MAX_W) * VIEW_MAX_H)
+
+#if defined(__GNUC__)
+#define FRAME_ALIGNED       __attribute__((aligned(FRAME_ALIGN)))
+#else
+#define FRAME_ALIGNED
+#endif
+
+static uint8_t frame_arena[FRAME_ARENA_SIZE] FRAME_ALIGNED;
+static uint16_t frame_arena_used = 0;
+
+// Switch the viewport to w x h. Frames allocated before are released (they
+// no longer fit), so callers allocate again. Returns false, leaving the
+// viewport as it was, if w x h is outside VIEW_MIN..VIEW_MAX.
+bool set_viewport(int w, int h) {
+    if (w < VIEW_MIN_W || w > VIEW_MAX_W || h < VIEW_MIN_H || h > VIEW_MAX_H) return false;
+    view_w = (uint8_t)w;
+    view_h = (uint8_t)h;
+    frame_arena_used = 0;
+    return true;
+}
+
+// Carve a frame of the current viewport size from the frame arena. Returns
+// false when the arena already holds two frames.
+bool frame_alloc(Frame* frame) {
+    uint16_t stride = FRAME_STRIDE(VIEW_W);
+    uint16_t size = (uint16_t)(stride * VIEW_H);
+    
+    if (size > FRAME_ARENA_SIZE - frame_arena_used) return false;
+    frame->cells = &frame_arena[frame_arena_used];
+    frame->stride = stride;
+    frame->w = view_w;
+    frame->h = view_h;
+    frame_arena_used += size;
+    return true;
+}
+#endif
+
+// Render the whole frame. A frame left over from before the last viewport
+// change is stale and is not drawn into.
+void render_frame(const GameState* game, Frame* frame) {
+    if (frame->w != VIEW_W || frame->h != VIEW_H) return;
+    render_rows(game, frame->cells, frame->stride, 0, frame->h);
+}
+
 // Main game update
 void update_game(GameState* game) {
+    // Loading ticks build the next slice of the level instead of simulating
+    if (LEVEL_LOADING(game)) {
+        level_build_step(game);
+        return;
+    }
+    
     if (!game->game_over) {
         game->frame_count++;
+#if MAP_STREAMED
+        // Collision and AI mostly probe the neighbourhood of the player
+        int px = COORD_TILE(game->player_x);
+        int py = COORD_TILE(game->player_y);
+        map_stream_prefetch(px - MAP_CHUNK, py - MAP_CHUNK, px + MAP_CHUNK, py + MAP_CHUNK);
+#endif
         update_bullets(game);
         update_enemies(game);
     }
 }
 
-// Initialize new game
-void init_game(GameState* game) {
+// Initialize new game from a seed (0 selects the default seed)
+void init_game_seeded(GameState* game, uint32_t seed) {
+    if (seed == 0) seed = GAME_DEFAULT_SEED;
     memset(game, 0, sizeof(GameState));
+    game->seed = seed;
+    game->rng = seed;
     game->health = 100;
     game->ammo = 20;
     game->level = 1;
     init_level(game, 1);
 }
 
+// Initialize new game
+void init_game(GameState* game) {
+    init_game_seeded(game, GAME_DEFAULT_SEED);
+}
+
 // Input processing
 void process_game_input(GameState* game, char input) {
+    if (LEVEL_LOADING(game)) return;   // Input is dropped while a level loads
+    
     switch (input) {
         case 'w': case 'W': move_player(game, 1, 0); break;
         case 's': case 'S': move_player(game, -1, 0); break;
@@ -498,10 +1934,112 @@ void process_game_input(GameState* game, char input) {
         case 'q': case 'Q': turn_player(game, -1); break;
         case 'e': case 'E': turn_player(game, 1); break;
         case ' ': fire_bullet(game); break;
+        case 'f': case 'F': switch_weapon(game); break;
         case 'r': case 'R': 
             if (game->game_over) {
-                init_game(game);
+                init_game_seeded(game, game->seed);
             }
             break;
     }
 }
+
+// Advance the simulation by one fixed tick. The result depends only on the
+// previous state and 'input' (0 = no key), never on rendering or wall-clock
+// time, so two builds fed the same seed and inputs stay in lockstep.
+void step_game(GameState* game, char input) {
+    if (input) process_game_input(game, input);
+    update_game(game);
+}
+
+// FNV-1a over simulation state only (rendered screens are derived data).
+// Multi-byte fields are fed low byte first so card and host builds agree.
+// Cheap enough to compare every tick for replay and cross-build checks.
+#define STATE_HASH_INIT  0x811C9DC5u
+#define STATE_HASH_PRIME 0x01000193u
+
+static uint32_t hash_u8(uint32_t h, uint8_t v) {
+    return (h ^ v) * STATE_HASH_PRIME;
+}
+
+static uint32_t hash_u16(uint32_t h, uint16_t v) {
+    return hash_u8(hash_u8(h, (uint8_t)v), (uint8_t)(v >> 8));
+}
+
+static uint32_t hash_u32(uint32_t h, uint32_t v) {
+    return hash_u16(hash_u16(h, (uint16_t)v), (uint16_t)(v >> 16));
+}
+
+// Positions and velocities at their full width (32 bits on large host worlds)
+#if COORD_BITS == 32
+#define hash_coord(h, c) hash_u32(h, (uint32_t)(c))
+#else
+#define hash_coord(h, c) hash_u16(h, (uint16_t)(c))
+#endif
+
+// The hash is taken in three parts so that save_state.c can hash a
+// snapshot's entities as it reads them, without pools to hold them:
+// the player and clocks, then each live enemy and bullet, then the level
+static uint32_t hash_state_head(const GameState* game) {
+    uint32_t h = STATE_HASH_INIT;
+    
+    h = hash_coord(h, game->player_x);
+    h = hash_coord(h, game->player_y);
+    h = hash_u16(h, game->player_angle);
+    h = hash_u8(h, game->health);
+    h = hash_u8(h, game->ammo);
+    h = hash_u8(h, game->level);
+    h = hash_u8(h, game->weapon);
+    h = hash_u8(h, (uint8_t)((game->game_over ? 1 : 0) | (game->victory ? 2 : 0)));
+    h = hash_u16(h, game->frame_count);
+    return hash_u32(h, game->rng);
+}
+
+// Enemy i; 'lod' is its coarse, dormant and idle bits (bits 0-2)
+static uint32_t hash_enemy(uint32_t h, int i, coord_t x, coord_t y, uint8_t health,
+                           uint8_t wait, uint8_t lod) {
+    h = hash_u8(h, (uint8_t)i);
+    h = hash_coord(h, x);
+    h = hash_coord(h, y);
+    h = hash_u8(h, health);
+    h = hash_u8(h, wait);
+    return hash_u8(h, lod);
+}
+
+static uint32_t hash_bullet(uint32_t h, int i, coord_t x, coord_t y,
+                            coord_delta_t dx, coord_delta_t dy) {
+    h = hash_u8(h, (uint8_t)(0x80 | i));
+    h = hash_coord(h, x);
+    h = hash_coord(h, y);
+    h = hash_coord(h, dx);
+    return hash_coord(h, dy);
+}
+
+// The layout is a function of seed and level; only the edits are state
+static uint32_t hash_state_tail(uint32_t h, const GameState* game) {
+    h = hash_u32(h, game->seed);
+    h = hash_u32(h, (uint32_t)game->pickups_taken);
+    h = hash_u32(h, (uint32_t)game->doors_open);
+    if (LEVEL_LOADING(game)) {
+        h = hash_u8(h, game->build_stage);
+        h = hash_u16(h, game->build_pos);
+        h = hash_u32(h, game->build_rng);
+    }
+    return h;
+}
+
+uint32_t game_state_hash(const GameState* game) {
+    const EnemyPool* e = &game->enemies;
+    const BulletPool* b = &game->bullets;
+    uint32_t h = hash_state_head(game);
+    int i;
+    
+    // Free slots hold stale data, so only live entities contribute
+    FOR_EACH_LIVE(EnemyMask, e->live, i) {
+        h = hash_enemy(h, i, e->x[i], e->y[i], e->health[i], enemy_wait(game, i),
+                       (uint8_t)((e->coarse >> i & 1) | (e->dormant >> i & 1) << 1 | (e->idle >> i & 1) << 2));
+    }
+    FOR_EACH_LIVE(BulletMask, b->live, i) {
+        h = hash_bullet(h, i, b->x[i], b->y[i], b->dx[i], b->dy[i]);
+    }
+    return hash_state_tail(h, game);
+}
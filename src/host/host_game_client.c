@@ -59,6 +59,7 @@ char getch() {
 #define INS_UPDATE_GAME     0x03
 #define INS_GET_SCREEN      0x04
 #define INS_GET_STATUS      0x05
+#define INS_GET_RESPONSE    0xC0
 
 // Simulated SIM card communication
 // In real implementation, this would use PC/SC
@@ -138,25 +139,34 @@ bool update_game_on_sim() {
     return sim_send_apdu(cmd, sizeof(cmd), resp, &resp_len);
 }
 
+// The card may send the screen in row chunks, each announced by 61 xx;
+// the rest comes with GET RESPONSE
 bool get_screen_from_sim(uint8_t* screen) {
     uint8_t cmd[] = {CLA_DOOM, INS_GET_SCREEN, 0x00, 0x00, 0x00};
+    uint8_t more[] = {0x00, INS_GET_RESPONSE, 0x00, 0x00, 0x00};
     uint8_t resp[1024];
-    uint16_t resp_len;
+    uint16_t resp_len, got = 0;
     
     if (!sim_send_apdu(cmd, sizeof(cmd), resp, &resp_len)) {
         return false;
     }
     
-    if (resp_len >= SCREEN_W * SCREEN_H + 2) {
-        memcpy(screen, resp, SCREEN_W * SCREEN_H);
-        return true;
+    while (resp_len >= 2 && got + resp_len - 2 <= SCREEN_W * SCREEN_H) {
+        memcpy(&screen[got], resp, resp_len - 2);
+        got += resp_len - 2;
+        if (resp[resp_len - 2] != 0x61) break;
+        more[4] = resp[resp_len - 1];
+        if (!sim_send_apdu(more, sizeof(more), resp, &resp_len)) {
+            return false;
+        }
     }
     
-    return false;
+    return got == SCREEN_W * SCREEN_H && resp[resp_len - 2] == 0x90;
 }
 
 bool get_status_from_sim(uint8_t* health, uint8_t* ammo, uint8_t* level, 
-                        bool* game_over, bool* victory) {
+                        bool* game_over, bool* victory,
+                        bool* loading, uint8_t* progress) {
     uint8_t cmd[] = {CLA_DOOM, INS_GET_STATUS, 0x00, 0x00, 0x00};
     uint8_t resp[256];
     uint16_t resp_len;
@@ -171,6 +181,9 @@ bool get_status_from_sim(uint8_t* health, uint8_t* ammo, uint8_t* level,
         *level = resp[2];
         *game_over = resp[3] != 0;
         *victory = resp[4] != 0;
+        // Older cards send no loading bytes; treat them as always ready
+        *loading = resp_len >= 9 && resp[5] != 0;
+        *progress = resp_len >= 9 ? resp[6] : 100;
         return true;
     }
     
@@ -198,6 +211,7 @@ int main(int argc, char* argv[]) {
     printf("  W/A/S/D = Move\n");
     printf("  Q/E = Turn\n");
     printf("  SPACE = Fire\n");
+    printf("  F = Switch weapon\n");
     printf("  ESC = Quit\n\n");
     
     printf("Press any key to start...\n");
@@ -237,10 +251,14 @@ int main(int argc, char* argv[]) {
         display_screen(screen);
         
         // Get status
-        uint8_t health, ammo, level;
-        bool game_over, victory;
-        if (get_status_from_sim(&health, &ammo, &level, &game_over, &victory)) {
+        uint8_t health, ammo, level, progress = 0;
+        bool game_over, victory, loading = false;
+        if (get_status_from_sim(&health, &ammo, &level, &game_over, &victory,
+                                &loading, &progress)) {
             printf("\nStatus: Health=%d Ammo=%d Level=%d", health, ammo, level);
+            if (loading) {
+                printf(" - loading %d%%", progress);
+            }
             if (game_over) {
                 printf(" - %s!", victory ? "VICTORY" : "GAME OVER");
             }
@@ -1,44 +1,119 @@
 /*
  * Memory Manager for SIM Card Environment
  * Manages the extremely limited memory available on SIM cards
+ *
+ * The heap is carved into fixed arenas by lifetime (see SimArena). Each is
+ * a bump allocator: allocation moves the top up, and memory comes back
+ * only by rewinding to an earlier mark or resetting the whole arena, both
+ * O(1). Released memory is not cleared, so callers initialise what they
+ * allocate.
  */
 
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
+#include "sim_doom.h"
 
 // Memory pools
-#define HEAP_SIZE 4096  // 4KB heap (half of our 8KB RAM)
+#define HEAP_SIZE (ARENA_PERSISTENT_SIZE + ARENA_LEVEL_SIZE + ARENA_TRANSIENT_SIZE)
 
 static uint8_t heap[HEAP_SIZE];
-static uint16_t heap_ptr = 0;
 
-// Simple bump allocator (no free - SIM card style)
-void* sim_malloc(uint16_t size) {
+static const uint16_t arena_base[ARENA_COUNT] = {
+    0,
+    ARENA_PERSISTENT_SIZE,
+    ARENA_PERSISTENT_SIZE + ARENA_LEVEL_SIZE
+};
+
+static ArenaStats arenas[ARENA_COUNT] = {
+    {ARENA_PERSISTENT_SIZE, 0, 0},
+    {ARENA_LEVEL_SIZE, 0, 0},
+    {ARENA_TRANSIENT_SIZE, 0, 0}
+};
+
+// RAM the card reports free for the applet. A card build would ask the
+// card OS; hosts emulate a card of SIM_CARD_RAM bytes, or whatever
+// sim_set_card_ram() says.
+static uint32_t card_ram = SIM_CARD_RAM;
+
+uint32_t sim_card_ram(void) {
+    return card_ram;
+}
+
+void sim_set_card_ram(uint32_t bytes) {
+    card_ram = bytes;
+}
+
+// Bump allocate from 'arena'. Returns NULL when it is full.
+void* sim_arena_alloc(SimArena arena, uint16_t size) {
+    ArenaStats* a = &arenas[arena];
+    
     // Align to 2 bytes
     if (size & 1) size++;
     
-    if (heap_ptr + size > HEAP_SIZE) {
+    if (size > a->size - a->used) {
         return NULL;  // Out of memory
     }
     
-    void* ptr = &heap[heap_ptr];
-    heap_ptr += size;
+    void* ptr = &heap[arena_base[arena] + a->used];
+    a->used += size;
+    if (a->used > a->high_water) a->high_water = a->used;
     return ptr;
 }
 
-// Reset heap (typically done between APDU commands)
+// Current top of 'arena', to rewind to once scratch work is done
+ArenaMark sim_arena_mark(SimArena arena) {
+    return arenas[arena].used;
+}
+
+// Release everything allocated from 'arena' since 'mark' was taken
+void sim_arena_rewind(SimArena arena, ArenaMark mark) {
+    if (mark < arenas[arena].used) arenas[arena].used = mark;
+}
+
+void sim_arena_reset(SimArena arena) {
+    arenas[arena].used = 0;
+}
+
+const ArenaStats* sim_arena_get_stats(SimArena arena) {
+    return &arenas[arena];
+}
+
+// Restart high-water tracking from the current use
+void sim_arena_reset_stats(SimArena arena) {
+    arenas[arena].high_water = arenas[arena].used;
+}
+
+// Session-lifetime allocation (no free - SIM card style)
+void* sim_malloc(uint16_t size) {
+    return sim_arena_alloc(ARENA_PERSISTENT, size);
+}
+
+// Release every arena
 void sim_heap_reset(void) {
-    heap_ptr = 0;
-    memset(heap, 0, HEAP_SIZE);
+    for (int i = 0; i < ARENA_COUNT; i++) {
+        sim_arena_reset((SimArena)i);
+    }
 }
 
-// Get free memory
+// Get free memory (all arenas)
 uint16_t sim_get_free_memory(void) {
-    return HEAP_SIZE - heap_ptr;
+    uint16_t free_bytes = 0;
+    for (int i = 0; i < ARENA_COUNT; i++) {
+        free_bytes += arenas[i].size - arenas[i].used;
+    }
+    return free_bytes;
 }
 
-// Initialize memory manager
-void sim_memory_init(void) {
+// Initialize memory manager: release everything and give the level arena
+// whatever RAM the card has beyond 'fixed_ram', all the applet holds
+// outside the level arena (up to ARENA_LEVEL_SIZE, all it can use)
+void sim_memory_init(uint32_t fixed_ram) {
+    uint32_t level = card_ram > fixed_ram ? card_ram - fixed_ram : 0;
+    
+    arenas[ARENA_LEVEL].size = (uint16_t)(level < ARENA_LEVEL_SIZE ? level : ARENA_LEVEL_SIZE);
     sim_heap_reset();
+    for (int i = 0; i < ARENA_COUNT; i++) {
+        sim_arena_reset_stats((SimArena)i);
+    }
 }
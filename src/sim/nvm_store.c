@@ -0,0 +1,241 @@
+/*
+ * NVM Store - Emulated EEPROM/flash for the SIM card environment
+ * Real cards program NVM a page at a time, slowly, and each page wears out
+ * after a limited number of writes. Writes land in a small RAM write-back
+ * cache and only reach NVM when a dirty page is evicted or flushed, and
+ * every page program is counted so features can be costed before they ship.
+ *
+ * On Linux hosts the NVM image is a memory-mapped file that survives
+ * across runs; elsewhere (and on card builds) it is a RAM array standing
+ * in for the card OS's NVM driver.
+ */
+
+#if defined(__unix__) && !defined(SIM_CARD_TARGET)
+#define _POSIX_C_SOURCE 200809L
+#define NVM_FILE_BACKED 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define NVM_FILE_BACKED 0
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "sim_doom.h"
+
+#define NVM_PAGES   (NVM_SIZE / NVM_PAGE_SIZE)
+#define NVM_ERASED  0xFF
+
+// Write-back cache slot
+typedef struct {
+    uint16_t page;
+    uint8_t valid;
+    uint8_t dirty;
+    uint8_t stamp;          // LRU age
+    uint8_t data[NVM_PAGE_SIZE];
+} NvmCacheSlot;
+
+static NvmCacheSlot cache[NVM_CACHE_PAGES];
+static uint8_t clock_stamp = 0;
+static NvmStats stats;
+
+static uint8_t* nvm = NULL;
+static uint8_t nvm_image[NVM_SIZE];     // In-memory image when not mapped
+static bool nvm_image_erased = false;
+#if NVM_FILE_BACKED
+static int nvm_fd = -1;
+#endif
+
+#ifndef SIM_CARD_TARGET
+// Per-page program counts (host only; a card cannot spare the RAM)
+static uint16_t page_wear[NVM_PAGES];
+#endif
+
+// Program one page into NVM, skipping pages whose contents did not change
+static void program_page(NvmCacheSlot* slot) {
+    uint8_t* dst = &nvm[(uint32_t)slot->page * NVM_PAGE_SIZE];
+    
+    slot->dirty = 0;
+    if (memcmp(dst, slot->data, NVM_PAGE_SIZE) == 0) {
+        stats.programs_skipped++;
+        return;
+    }
+    
+    memcpy(dst, slot->data, NVM_PAGE_SIZE);
+    stats.page_programs++;
+    stats.bytes_programmed += NVM_PAGE_SIZE;
+    stats.program_us += NVM_PROGRAM_US;
+#ifndef SIM_CARD_TARGET
+    if (++page_wear[slot->page] > stats.max_page_wear) {
+        stats.max_page_wear = page_wear[slot->page];
+    }
+#endif
+}
+
+static NvmCacheSlot* find_slot(uint16_t page) {
+    for (int i = 0; i < NVM_CACHE_PAGES; i++) {
+        if (cache[i].valid && cache[i].page == page) return &cache[i];
+    }
+    return NULL;
+}
+
+// Get a cache slot for 'page', evicting the least recently used one
+static NvmCacheSlot* load_slot(uint16_t page) {
+    NvmCacheSlot* slot = find_slot(page);
+    
+    if (slot) {
+        stats.cache_hits++;
+    } else {
+        stats.cache_misses++;
+        slot = &cache[0];
+        for (int i = 0; i < NVM_CACHE_PAGES; i++) {
+            if (!cache[i].valid) { slot = &cache[i]; break; }
+            if ((uint8_t)(clock_stamp - cache[i].stamp) > (uint8_t)(clock_stamp - slot->stamp)) {
+                slot = &cache[i];
+            }
+        }
+        if (slot->valid && slot->dirty) program_page(slot);
+        
+        slot->page = page;
+        slot->valid = 1;
+        slot->dirty = 0;
+        memcpy(slot->data, &nvm[(uint32_t)page * NVM_PAGE_SIZE], NVM_PAGE_SIZE);
+    }
+    
+    slot->stamp = ++clock_stamp;
+    return slot;
+}
+
+// Attach the NVM image. 'backing_path' names the host file to map (created
+// erased if missing); NULL, or a card build, uses the in-memory image,
+// which persists until the process exits.
+bool nvm_init(const char* backing_path) {
+    nvm_close();
+    memset(cache, 0, sizeof(cache));
+    nvm_reset_stats();
+    
+#if NVM_FILE_BACKED
+    if (backing_path) {
+        nvm_fd = open(backing_path, O_RDWR | O_CREAT, 0644);
+        if (nvm_fd < 0) return false;
+        
+        off_t size = lseek(nvm_fd, 0, SEEK_END);
+        if (size != NVM_SIZE) {
+            uint8_t erased[NVM_PAGE_SIZE];
+            memset(erased, NVM_ERASED, sizeof(erased));
+            if (ftruncate(nvm_fd, 0) != 0 || lseek(nvm_fd, 0, SEEK_SET) != 0) goto fail;
+            for (uint32_t i = 0; i < NVM_PAGES; i++) {
+                if (write(nvm_fd, erased, NVM_PAGE_SIZE) != NVM_PAGE_SIZE) goto fail;
+            }
+        }
+        
+        void* map = mmap(NULL, NVM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, nvm_fd, 0);
+        if (map == MAP_FAILED) goto fail;
+        nvm = (uint8_t*)map;
+        return true;
+    
+    fail:
+        close(nvm_fd);
+        nvm_fd = -1;
+        return false;
+    }
+#else
+    (void)backing_path;
+#endif
+    // Like real NVM, the image keeps its contents across remounts; it
+    // starts out erased
+    if (!nvm_image_erased) {
+        memset(nvm_image, NVM_ERASED, NVM_SIZE);
+        nvm_image_erased = true;
+    }
+    nvm = nvm_image;
+    return true;
+}
+
+// Flush the cache and detach the image
+void nvm_close(void) {
+    if (!nvm) return;
+    nvm_flush();
+#if NVM_FILE_BACKED
+    if (nvm_fd >= 0) {
+        msync(nvm, NVM_SIZE, MS_SYNC);
+        munmap(nvm, NVM_SIZE);
+        close(nvm_fd);
+        nvm_fd = -1;
+    }
+#endif
+    nvm = NULL;
+}
+
+// True while an image is attached
+bool nvm_ready(void) {
+    return nvm != NULL;
+}
+
+// Read through the cache (dirty pages are visible before they are flushed).
+// Returns false if no image is attached or the read runs past the image.
+bool nvm_read(uint32_t addr, void* dst, uint16_t len) {
+    uint8_t* out = (uint8_t*)dst;
+    
+    if (!nvm || addr + len > NVM_SIZE) return false;
+    
+    while (len) {
+        uint16_t page = (uint16_t)(addr / NVM_PAGE_SIZE);
+        uint16_t off = (uint16_t)(addr % NVM_PAGE_SIZE);
+        uint16_t n = NVM_PAGE_SIZE - off;
+        if (n > len) n = len;
+        
+        NvmCacheSlot* slot = find_slot(page);
+        memcpy(out, slot ? &slot->data[off] : &nvm[addr], n);
+        
+        stats.bytes_read += n;
+        out += n;
+        addr += n;
+        len -= n;
+    }
+    return true;
+}
+
+// Stage a write in the cache. Returns false if it runs past the image.
+bool nvm_write(uint32_t addr, const void* src, uint16_t len) {
+    const uint8_t* in = (const uint8_t*)src;
+    
+    if (!nvm || addr + len > NVM_SIZE) return false;
+    stats.bytes_requested += len;
+    
+    while (len) {
+        uint16_t off = (uint16_t)(addr % NVM_PAGE_SIZE);
+        uint16_t n = NVM_PAGE_SIZE - off;
+        if (n > len) n = len;
+        
+        NvmCacheSlot* slot = load_slot((uint16_t)(addr / NVM_PAGE_SIZE));
+        memcpy(&slot->data[off], in, n);
+        slot->dirty = 1;
+        
+        in += n;
+        addr += n;
+        len -= n;
+    }
+    return true;
+}
+
+// Program every dirty page (call at a commit point, e.g. end of a save)
+void nvm_flush(void) {
+    if (!nvm) return;
+    for (int i = 0; i < NVM_CACHE_PAGES; i++) {
+        if (cache[i].valid && cache[i].dirty) program_page(&cache[i]);
+    }
+}
+
+const NvmStats* nvm_get_stats(void) {
+    return &stats;
+}
+
+void nvm_reset_stats(void) {
+    memset(&stats, 0, sizeof(stats));
+#ifndef SIM_CARD_TARGET
+    memset(page_wear, 0, sizeof(page_wear));
+#endif
+}
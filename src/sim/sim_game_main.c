@@ -13,6 +13,8 @@
 
 // Include game logic (it defines its own structures)
 #include "../doom/text_doom_game.c"
+#include "../doom/save_state.c"
+#include "sim_doom.h"
 
 // APDU Commands
 #define CLA_DOOM            0x80
@@ -22,6 +24,11 @@
 #define INS_GET_SCREEN      0x04
 #define INS_GET_STATUS      0x05
 #define INS_RESET_GAME      0x06
+#define INS_GET_STATE_HASH  0x07
+#define INS_SAVE_STATE      0x08
+#define INS_LOAD_STATE      0x09
+#define INS_GET_STATS       0x0A
+#define INS_GET_RESPONSE    0xC0
 
 // APDU Status words
 #define SW_SUCCESS          0x9000
@@ -33,6 +40,223 @@
 static GameState game;
 static bool initialized = false;
 
+static void set_sw(uint8_t* resp, uint16_t pos, uint8_t sw1, uint8_t sw2, uint16_t* resp_len) {
+    resp[pos] = sw1;
+    resp[pos + 1] = sw2;
+    *resp_len = pos + 2;
+}
+
+static uint16_t put32(uint8_t* resp, uint16_t pos, uint32_t v) {
+    resp[pos] = (uint8_t)(v >> 24);
+    resp[pos + 1] = (uint8_t)(v >> 16);
+    resp[pos + 2] = (uint8_t)(v >> 8);
+    resp[pos + 3] = (uint8_t)v;
+    return pos + 4;
+}
+
+static uint16_t put16(uint8_t* resp, uint16_t pos, uint16_t v) {
+    resp[pos] = (uint8_t)(v >> 8);
+    resp[pos + 1] = (uint8_t)v;
+    return pos + 2;
+}
+
+// Largest response body. A card answers within one short APDU and sends
+// a screen as row chunks behind 61 xx, even when all of it is asked for;
+// host builds can return a whole frame at once.
+#define CARD_RESP_DATA      256
+#ifdef SIM_CARD_TARGET
+#define RESP_DATA_MAX       CARD_RESP_DATA
+#else
+#define RESP_DATA_MAX       (VIEW_MAX_W * VIEW_MAX_H)
+#endif
+STATIC_ASSERT(VIEW_MAX_W <= RESP_DATA_MAX, a_screen_row_fits_a_response);
+
+// Rows still owed to GET RESPONSE after a partial GET_SCREEN (0 = none)
+static uint8_t screen_next_row = 0;
+static uint8_t screen_chunk_rows = 0;
+
+// Render rows [first, first + count) straight into the response. A chunk
+// that stops short of the last row answers 61 xx (xx = bytes left, capped
+// at FF) and the host fetches the rest with GET RESPONSE.
+static void send_screen_rows(uint8_t first, uint8_t count, uint8_t* resp, uint16_t* resp_len) {
+    if (first + count > VIEW_H) count = (uint8_t)(VIEW_H - first);
+    if (count > RESP_DATA_MAX / VIEW_W) count = (uint8_t)(RESP_DATA_MAX / VIEW_W);
+    render_rows(&game, resp, VIEW_W, first, count);
+    
+    uint16_t pos = (uint16_t)(count * VIEW_W);
+    uint16_t remaining = (uint16_t)((VIEW_H - first - count) * VIEW_W);
+    if (remaining) {
+        screen_next_row = first + count;
+        screen_chunk_rows = count;
+        set_sw(resp, pos, 0x61, remaining > 0xFF ? 0xFF : (uint8_t)remaining, resp_len);
+    } else {
+        screen_chunk_rows = 0;
+        set_sw(resp, pos, 0x90, 0x00, resp_len);
+    }
+}
+
+// GET_STATS: P1 = counter page (00 map chunk cache, 01 NVM, 02 memory
+// arenas), P2 = 01 to reset the page's counters after reading them.
+// Counters are big-endian.
+static void apdu_get_stats(uint8_t page, uint8_t reset, uint8_t* resp, uint16_t* resp_len) {
+    uint16_t pos = 0;
+    
+    switch (page) {
+        case 0x00:
+#if MAP_STREAMED
+        {
+            const MapStreamStats* st = map_stream_get_stats();
+            pos = put32(resp, pos, st->lookups);
+            pos = put32(resp, pos, st->hits);
+            pos = put32(resp, pos, st->misses);
+            pos = put32(resp, pos, st->prefetched);
+            if (reset) map_stream_reset_stats();
+            break;
+        }
+#else
+            set_sw(resp, 0, 0x69, 0x85, resp_len);  // Map is not streamed
+            return;
+#endif
+        case 0x01:
+        {
+            const NvmStats* st = nvm_get_stats();
+            pos = put32(resp, pos, st->page_programs);
+            pos = put32(resp, pos, st->bytes_programmed);
+            pos = put32(resp, pos, st->bytes_read);
+            pos = put32(resp, pos, st->cache_hits);
+            pos = put32(resp, pos, st->cache_misses);
+            if (reset) nvm_reset_stats();
+            break;
+        }
+        case 0x02:
+            // Size, in use and high-water mark of each arena, in SimArena order
+            for (int i = 0; i < ARENA_COUNT; i++) {
+                const ArenaStats* st = sim_arena_get_stats((SimArena)i);
+                pos = put16(resp, pos, st->size);
+                pos = put16(resp, pos, st->used);
+                pos = put16(resp, pos, st->high_water);
+                if (reset) sim_arena_reset_stats((SimArena)i);
+            }
+            break;
+        default:
+            set_sw(resp, 0, 0x6B, 0x00, resp_len);
+            return;
+    }
+    set_sw(resp, pos, 0x90, 0x00, resp_len);
+}
+
+#if HAS_SAVE_STATES
+// Snapshot bytes per SAVE_STATE response (fits a short APDU)
+#define SNAPSHOT_CHUNK 240
+
+// LOAD_STATE staging: chunks must arrive in order, starting at offset 0.
+// The buffer is taken from the persistent arena on the first upload of a
+// session (INIT_GAME releases it with the rest of the heap).
+STATIC_ASSERT(SNAPSHOT_MAX <= ARENA_PERSISTENT_SIZE, snapshot_staging_fits_persistent_arena);
+static uint8_t* snapshot_buf = NULL;
+static uint16_t snapshot_received = 0;
+
+// SAVE_STATE: P1P2 = offset into the snapshot. Returns the next chunk with
+// 90 00 if it is the last one, or 61 xx while xx more bytes remain.
+static void apdu_save_state(uint16_t offset, uint8_t* resp, uint16_t* resp_len) {
+    uint16_t total = save_state_read(&game, offset, resp, SNAPSHOT_CHUNK);
+    
+    if (total == 0) {
+        set_sw(resp, 0, 0x69, 0x85, resp_len);  // Conditions not satisfied
+        return;
+    }
+    if (offset >= total) {
+        set_sw(resp, 0, 0x6B, 0x00, resp_len);  // Offset past the end
+        return;
+    }
+    
+    uint16_t n = total - offset;
+    if (n > SNAPSHOT_CHUNK) n = SNAPSHOT_CHUNK;
+    uint16_t remaining = total - offset - n;
+    
+    if (remaining) {
+        set_sw(resp, n, 0x61, remaining > 0xFF ? 0xFF : (uint8_t)remaining, resp_len);
+    } else {
+        set_sw(resp, n, 0x90, 0x00, resp_len);
+    }
+}
+
+// LOAD_STATE: P1P2 = offset, data = next chunk. The game is replaced once
+// the final chunk arrives and the snapshot checks out.
+static void apdu_load_state(uint16_t offset, const uint8_t* cmd, uint16_t cmd_len,
+                            uint8_t* resp, uint16_t* resp_len) {
+    if (cmd_len < 5 || cmd_len < 5 + cmd[4]) {
+        set_sw(resp, 0, 0x67, 0x00, resp_len);
+        return;
+    }
+    uint8_t lc = cmd[4];
+    
+    if (offset == 0) snapshot_received = 0;
+    if (offset != snapshot_received) {
+        set_sw(resp, 0, 0x6B, 0x00, resp_len);  // Out-of-order chunk
+        return;
+    }
+    if (offset + lc > SNAPSHOT_MAX) {
+        snapshot_received = 0;
+        set_sw(resp, 0, 0x6A, 0x80, resp_len);  // Larger than any snapshot
+        return;
+    }
+    if (!snapshot_buf) snapshot_buf = sim_arena_alloc(ARENA_PERSISTENT, SNAPSHOT_MAX);
+    if (!snapshot_buf) {
+        set_sw(resp, 0, 0x69, 0x85, resp_len);  // Heap taken by something else
+        return;
+    }
+    
+    memcpy(&snapshot_buf[offset], &cmd[5], lc);
+    snapshot_received += lc;
+    
+    if (snapshot_received >= SNAP_HEADER_SIZE) {
+        uint16_t total = (uint16_t)((snapshot_buf[3] << 8) | snapshot_buf[4]);
+        
+        if (total < SNAP_HEADER_SIZE || total > SNAPSHOT_MAX || snapshot_received > total) {
+            snapshot_received = 0;
+            set_sw(resp, 0, 0x6A, 0x80, resp_len);
+            return;
+        }
+        if (snapshot_received == total) {
+            snapshot_received = 0;
+            if (!save_state_apply(&game, snapshot_buf, total)) {
+                set_sw(resp, 0, 0x6A, 0x80, resp_len);  // The running game is untouched
+                return;
+            }
+            initialized = true;
+        }
+    }
+    
+    set_sw(resp, 0, 0x90, 0x00, resp_len);
+}
+#endif
+
+// RAM the applet holds, by owner. The build fails if it outgrows the
+// profile's RAM_BUDGET; make memory-report prints the breakdown. The level
+// arena takes whatever the card has beyond RAM_FIXED (sim_memory_init), so
+// the adaptive profile, whose budget is its smallest card, only has to fit
+// RAM_FIXED and the minimal pools; RAM_TOTAL is what it holds on a card
+// with room to spare.
+#define RAM_GAME_STATE      sizeof(GameState)
+#define RAM_HEAP            (ARENA_PERSISTENT_SIZE + ARENA_LEVEL_SIZE + ARENA_TRANSIENT_SIZE)
+#define RAM_NVM_CACHE       (NVM_CACHE_PAGES * (NVM_PAGE_SIZE + 6))     // NvmCacheSlot
+#define RAM_APDU_BUFFERS    (256 + CARD_RESP_DATA + 2)                  // sim_main() on a card
+#if MAP_STREAMED
+#define RAM_MAP_CACHE       sizeof(map_cache)
+#else
+#define RAM_MAP_CACHE       0
+#endif
+#define RAM_TOTAL           (RAM_GAME_STATE + RAM_HEAP + RAM_NVM_CACHE + RAM_APDU_BUFFERS + \
+                             RAM_MAP_CACHE + SIM_APP_STACK)
+#define RAM_FIXED           (RAM_TOTAL - ARENA_LEVEL_SIZE)              // All but the level arena
+
+#if ADAPTIVE_CAPACITY
+STATIC_ASSERT(RAM_FIXED + LEVEL_ARENA_MIN <= RAM_BUDGET, applet_ram_exceeds_profile_budget);
+#else
+STATIC_ASSERT(RAM_TOTAL <= RAM_BUDGET, applet_ram_exceeds_profile_budget);
+#endif
+
 // Function prototypes for SIM card communication
 uint16_t receive_apdu(uint8_t* buffer);
 void send_apdu(const uint8_t* buffer, uint16_t len);
@@ -51,21 +275,41 @@ void process_apdu(const uint8_t* cmd, uint16_t cmd_len,
     
     uint8_t cla = cmd[0];
     uint8_t ins = cmd[1];
-    // uint8_t p1 = cmd[2];  // Not used yet
-    // uint8_t p2 = cmd[3];  // Not used yet
+    uint8_t p1 = cmd[2];
+    uint8_t p2 = cmd[3];
     
-    // Check class
-    if (cla != CLA_DOOM) {
+    // Check class (GET RESPONSE may also come with the ISO class)
+    if (cla != CLA_DOOM && !(cla == 0x00 && ins == INS_GET_RESPONSE)) {
         resp[0] = 0x6E;
         resp[1] = 0x00;
         *resp_len = 2;
         return;
     }
     
+    // Only a GET RESPONSE straight after a partial screen continues it
+    if (ins != INS_GET_RESPONSE) screen_chunk_rows = 0;
+    
     // Process instruction
     switch (ins) {
         case INS_INIT_GAME:
-            init_game(&game);
+            // P1P2 = seed (0000 = default seed). A new session starts with
+            // the heap sized to the card.
+            sim_memory_init(RAM_FIXED);
+#if HAS_SAVE_STATES
+            snapshot_buf = NULL;
+            snapshot_received = 0;
+#endif
+#if ADAPTIVE_CAPACITY
+            // A card without room for the minimal pools cannot play
+            if (sim_arena_get_stats(ARENA_LEVEL)->size < LEVEL_ARENA_MIN) {
+                initialized = false;
+                resp[0] = 0x69;
+                resp[1] = 0x85;
+                *resp_len = 2;
+                break;
+            }
+#endif
+            init_game_seeded(&game, ((uint32_t)p1 << 8) | p2);
             initialized = true;
             resp[0] = 0x90;
             resp[1] = 0x00;
@@ -73,13 +317,14 @@ void process_apdu(const uint8_t* cmd, uint16_t cmd_len,
             break;
             
         case INS_PROCESS_INPUT:
-            if (!initialized || cmd_len < 5) {
+            // Lc = 01, data = the key
+            if (!initialized || cmd_len < 6 || cmd[4] != 0x01) {
                 resp[0] = 0x67;
                 resp[1] = 0x00;
                 *resp_len = 2;
                 break;
             }
-            process_game_input(&game, cmd[4]);
+            process_game_input(&game, cmd[5]);
             resp[0] = 0x90;
             resp[1] = 0x00;
             *resp_len = 2;
@@ -93,7 +338,6 @@ void process_apdu(const uint8_t* cmd, uint16_t cmd_len,
                 break;
             }
             update_game(&game);
-            render_game(&game);
             resp[0] = 0x90;
             resp[1] = 0x00;
             *resp_len = 2;
@@ -106,11 +350,22 @@ void process_apdu(const uint8_t* cmd, uint16_t cmd_len,
                 *resp_len = 2;
                 break;
             }
-            // Return screen data
-            memcpy(resp, game.screen, SCREEN_W * SCREEN_H);
-            resp[SCREEN_W * SCREEN_H] = 0x90;
-            resp[SCREEN_W * SCREEN_H + 1] = 0x00;
-            *resp_len = SCREEN_W * SCREEN_H + 2;
+            // P1 = first row, P2 = rows per response (00 = as many as fit,
+            // through the last)
+            if (p1 >= VIEW_H) {
+                set_sw(resp, 0, 0x6B, 0x00, resp_len);
+                break;
+            }
+            send_screen_rows(p1, p2 ? p2 : (uint8_t)VIEW_H, resp, resp_len);
+            break;
+        
+        case INS_GET_RESPONSE:
+            // Next chunk of the screen announced by 61 xx
+            if (!initialized || !screen_chunk_rows) {
+                set_sw(resp, 0, 0x69, 0x85, resp_len);
+                break;
+            }
+            send_screen_rows(screen_next_row, screen_chunk_rows, resp, resp_len);
             break;
             
         case INS_GET_STATUS:
@@ -126,11 +381,57 @@ void process_apdu(const uint8_t* cmd, uint16_t cmd_len,
             resp[2] = game.level;
             resp[3] = game.game_over ? 1 : 0;
             resp[4] = game.victory ? 1 : 0;
-            resp[5] = 0x90;
-            resp[6] = 0x00;
-            *resp_len = 7;
+            resp[5] = LEVEL_LOADING(&game) ? 1 : 0;
+            resp[6] = level_build_progress(&game);
+            resp[7] = ENEMY_CAP(&game);
+            resp[8] = BULLET_CAP(&game);
+            resp[9] = 0x90;
+            resp[10] = 0x00;
+            *resp_len = 11;
             break;
             
+        case INS_GET_STATE_HASH:
+            if (!initialized) {
+                resp[0] = 0x69;
+                resp[1] = 0x86;
+                *resp_len = 2;
+                break;
+            }
+            // Return simulation hash (big-endian) and the tick it belongs to
+            {
+                uint32_t hash = game_state_hash(&game);
+                resp[0] = (uint8_t)(hash >> 24);
+                resp[1] = (uint8_t)(hash >> 16);
+                resp[2] = (uint8_t)(hash >> 8);
+                resp[3] = (uint8_t)hash;
+                resp[4] = (uint8_t)(game.frame_count >> 8);
+                resp[5] = (uint8_t)game.frame_count;
+            }
+            resp[6] = 0x90;
+            resp[7] = 0x00;
+            *resp_len = 8;
+            break;
+            
+#if HAS_SAVE_STATES
+        case INS_SAVE_STATE:
+            if (!initialized) {
+                resp[0] = 0x69;
+                resp[1] = 0x86;
+                *resp_len = 2;
+                break;
+            }
+            apdu_save_state((uint16_t)((p1 << 8) | p2), resp, resp_len);
+            break;
+            
+        case INS_LOAD_STATE:
+            apdu_load_state((uint16_t)((p1 << 8) | p2), cmd, cmd_len, resp, resp_len);
+            break;
+#endif
+            
+        case INS_GET_STATS:
+            apdu_get_stats(p1, p2, resp, resp_len);
+            break;
+        
         case INS_RESET_GAME:
             memset(&game, 0, sizeof(game));
             initialized = false;
@@ -145,12 +446,15 @@ void process_apdu(const uint8_t* cmd, uint16_t cmd_len,
             *resp_len = 2;
             break;
     }
+    
+    // Scratch memory never outlives the command that took it
+    sim_arena_reset(ARENA_TRANSIENT);
 }
 
 // Main entry point for SIM application
 void sim_main(void) {
     uint8_t cmd_buffer[256];
-    uint8_t resp_buffer[1024];  // Screen data is 1000 bytes
+    uint8_t resp_buffer[RESP_DATA_MAX + 2];  // Screen rows + status word
     uint16_t cmd_len, resp_len;
     
     // Main APDU loop
@@ -180,12 +484,6 @@ void send_apdu(const uint8_t* buffer, uint16_t len) {
     // Stub
 }
 
-// Memory usage summary:
-// GameState: ~3KB
-// Code: ~2KB  
-// Stack/misc: ~1KB
-// Total: ~6KB - fits comfortably in 8KB SIM memory!
-
 #ifdef TEST_BUILD
 // Test main for standalone testing
 int main(void) {
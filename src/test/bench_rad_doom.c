@@ -0,0 +1,457 @@
+/*
+ * RAD-Doom Benchmarks - the integer raycaster against the float marcher
+ * Build with make bench-rad. Both cast one ray per column from the
+ * same positions and draw into the same buffers; only the ray walk differs.
+ */
+
+#define _DEFAULT_SOURCE  // sysconf and clock_gettime under -std=c99
+
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+#include <unistd.h>
+
+// Include the engine
+#include "../doom/rad_doom_enhanced.c"
+
+static GameState game;
+static volatile uint32_t sink;   // Keeps results alive under -O2
+
+static double elapsed_ns(clock_t t0, clock_t t1, long ops) {
+    return (double)(t1 - t0) * 1e9 / CLOCKS_PER_SEC / ops;
+}
+
+// The ray the engine used to cast: a float march in 0.1-tile steps along
+// cos/sin of the column's angle (kept here as the baseline)
+static void cast_float_ray(GameState* game, float angle, int screen_x) {
+    float dx = cosf(angle);
+    float dy = sinf(angle);
+    float distance = 0;
+    float px = game->player_x / (float)RAD_FP, py = game->player_y / (float)RAD_FP;
+    
+    while (distance < 30) {
+        int map_x = (int)(px + dx * distance);
+        int map_y = (int)(py + dy * distance);
+        
+        if (map_x < 0 || map_x >= MAP_W || map_y < 0 || map_y >= MAP_H) break;
+        
+        uint8_t tile = game->map[map_y][map_x];
+        if (rad_blocks_sight(tile)) {
+            // Calculate wall height based on distance
+            int wall_half = (int)(RAD_HORIZON / (distance + 0.1f));
+            int wall_top = RAD_HORIZON - wall_half;
+            int wall_bottom = RAD_HORIZON + wall_half;
+            uint8_t depth = (uint8_t)(distance * 8);
+            
+            game->column_depth[screen_x] = depth;
+            for (int y = wall_top < 0 ? 0 : wall_top; y < wall_bottom && y < RAD_VIEW_H; y++) {
+                game->cells[screen_x][y] = RAD_CELL(select_wall_texture(tile, depth, y - wall_top),
+                                                    get_tile_color(tile));
+            }
+            break;
+        }
+        distance += 0.1f;
+    }
+}
+
+static void render_float_walls(GameState* game) {
+    memset(game->cells, RAD_CELL(GLYPH_BLANK, 0), sizeof(game->cells));
+    memset(game->column_depth, RAD_FAR, sizeof(game->column_depth));
+    
+    for (int x = 0; x < SCREEN_W; x++) {
+        float degrees = game->player_angle * 360.0f / 256 - 30 + x * 60.0f / SCREEN_W;
+        cast_float_ray(game, degrees * 3.14159f / 180.0f, x);
+    }
+}
+
+// Frames from a few spots in the first rooms, turning a full circle at each
+static long bench_walls(const char* name, void (*render)(GameState*)) {
+    static const uint8_t spots[][2] = {{10, 10}, {24, 9}, {9, 24}, {40, 24}};
+    const int spins = 20;
+    long frames = 0;
+    uint32_t acc = 0;
+    
+    init_rad_game(&game);
+    clock_t t0 = clock();
+    for (int n = 0; n < spins; n++) {
+        for (size_t s = 0; s < sizeof(spots) / sizeof(spots[0]); s++) {
+            game.player_x = spots[s][0] * RAD_FP + RAD_FP / 2;
+            game.player_y = spots[s][1] * RAD_FP + RAD_FP / 2;
+            for (int a = 0; a < 256; a++) {
+                game.player_angle = (uint8_t)a;
+                render(&game);
+                acc += game.column_depth[a % SCREEN_W];
+                frames++;
+            }
+        }
+    }
+    clock_t t1 = clock();
+    sink = acc;
+    
+    double ns = elapsed_ns(t0, t1, frames);
+    printf("%-14s %7.2f us/frame (%.1f ns/column, %ld frames)\n",
+           name, ns / 1000.0, ns / SCREEN_W, frames);
+    return (long)ns;
+}
+
+// The particle system the pool replaced: array-of-structs slots scanned
+// in full to spawn, update and draw (kept here as the baseline)
+#define OLD_PARTICLES 50
+
+typedef struct {
+    int16_t x, y;
+    int8_t vx, vy;
+    uint8_t life;
+    uint8_t type;
+    uint8_t glyph;
+} OldParticle;
+
+static OldParticle old_particles[OLD_PARTICLES];
+
+static void old_spawn(int16_t x, int16_t y, uint8_t type) {
+    for (int i = 0; i < OLD_PARTICLES; i++) {
+        if (old_particles[i].life == 0) {
+            OldParticle* p = &old_particles[i];
+            p->x = x;
+            p->y = y;
+            p->type = type;
+            p->life = 20 + (type * 10);
+            p->vx = (int)(rad_rand(&game) % 5) - 2;
+            p->vy = -(int)(rad_rand(&game) % 3);
+            p->glyph = GLYPH_STAR;
+            break;
+        }
+    }
+}
+
+static void old_frame(void) {
+    for (int i = 0; i < OLD_PARTICLES; i++) {
+        OldParticle* p = &old_particles[i];
+        if (p->life > 0) {
+            p->x += p->vx;
+            p->y += p->vy;
+            p->vy += 1;
+            p->life--;
+        }
+    }
+    for (int i = 0; i < OLD_PARTICLES; i++) {
+        const OldParticle* p = &old_particles[i];
+        if (p->life == 0) continue;
+        if (p->x < 0 || p->x >= SCREEN_W || p->y < 0 || p->y >= RAD_VIEW_H) continue;
+        game.cells[p->x][p->y] = RAD_CELL(p->glyph, 4);
+    }
+}
+
+static void new_spawn(int16_t x, int16_t y, uint8_t type) {
+    spawn_particle(&game, x, y, 0, type);
+}
+
+static void new_frame(void) {
+    update_particles(&game);
+    render_particles(&game);
+}
+
+// Particle spawn, update and draw per frame, spawning enough each tick to
+// keep 'capacity' particles alive (impacts live 20 ticks)
+static void bench_particles(const char* name, int capacity,
+                            void (*spawn)(int16_t, int16_t, uint8_t), void (*frame)(void)) {
+    const long reps = 200000;
+    int per_tick = capacity / 20;
+    
+    init_rad_game(&game);
+    render_rad_walls(&game);
+    memset(game.column_depth, RAD_FAR, sizeof(game.column_depth));
+    clock_t t0 = clock();
+    for (long n = 0; n < reps; n++) {
+        for (int k = 0; k < per_tick; k++) {
+            spawn((int16_t)(k % SCREEN_W), (int16_t)(k % RAD_VIEW_H), 0);
+        }
+        frame();
+    }
+    clock_t t1 = clock();
+    sink = game.cells[0][0];
+    
+    printf("%-14s %7.1f ns/frame (%d particles)\n", name, elapsed_ns(t0, t1, reps), capacity);
+}
+
+#if RAD_PARALLEL
+// Wall time (threads run alongside the caller, so clock() would add up
+// every thread's CPU time)
+static double wall_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// The walls cast on 1..N threads, checked byte for byte against the serial
+// path
+static void bench_threads(void) {
+    static uint8_t cells[SCREEN_W][RAD_VIEW_H], depths[SCREEN_W];
+    const int frames = 2000;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int most = cores > 1 ? (int)cores : 2;
+    double one = 0;
+    
+    if (most > RAD_MAX_THREADS) most = RAD_MAX_THREADS;
+    if (most > RAD_MAX_STRIPS) most = RAD_MAX_STRIPS;
+    printf("Threads (%ld cores, %d columns)\n", cores, SCREEN_W);
+    
+    init_rad_game(&game);
+    for (int threads = 1; threads <= most; threads++) {
+        int used = rad_pool_start(threads);
+        bool same = true;
+        
+        double t0 = wall_ns();
+        for (int n = 0; n < frames; n++) {
+            game.player_angle = (uint8_t)n;
+            render_rad_walls_parallel(&game);
+            
+            // Every 64th frame, cast it again serially and compare
+            if (n % 64 == 0) {
+                double c0 = wall_ns();
+                memcpy(cells, game.cells, sizeof(cells));
+                memcpy(depths, game.column_depth, sizeof(depths));
+                render_rad_walls(&game);
+                same = same && memcmp(cells, game.cells, sizeof(cells)) == 0 &&
+                       memcmp(depths, game.column_depth, sizeof(depths)) == 0;
+                t0 += wall_ns() - c0;
+            }
+        }
+        double ns = (wall_ns() - t0) / frames;
+        if (threads == 1) one = ns;
+        
+        // One strip per thread; the widest bounds the frame time
+        int widest = SCREEN_W;
+        if (used > 1) {
+            widest = 0;
+            for (int t = 0; t < used; t++) {
+                int cols = rad_pool.edge[t + 1] - rad_pool.edge[t];
+                if (cols > widest) widest = cols;
+            }
+        }
+        printf("  %2d thread%s  %2d strip%s of <= %3d columns  %8.2f us/frame  %5.2fx  %s\n",
+               used, used == 1 ? " " : "s", used, used == 1 ? " " : "s", widest,
+               ns / 1000.0, one / ns, same ? "identical" : "DIFFERS");
+    }
+    rad_pool_stop();
+    printf("\n");
+}
+#endif
+
+// Building the visibility sets and their size. From random spots and
+// headings, no view ray may reach a cluster outside the set it starts in,
+// and the enemies drawn must match a copy of the game that sees everywhere
+// (baked builds check the baked sets are the ones the map traces to).
+static void bench_pvs(void) {
+    static uint8_t built[RAD_CLUSTERS][RAD_PVS_BYTES];
+    const long builds = 20, spots = 20000;
+    long clusters = 0, sets = 0, leaks = 0, enemies = 0, culled = 0;
+    uint32_t rng = 0x9E3779B9u;
+    
+    init_rad_game(&game);
+    for (int i = 0; i < MAX_ENEMIES; i++) spawn_rad_enemy(&game, (uint8_t)(i % 3));
+    clock_t t0 = clock();
+    for (long n = 0; n < builds; n++) build_rad_pvs(&game, built);
+    clock_t t1 = clock();
+#ifdef RAD_PVS_BAKED
+    bool stale = memcmp(built, rad_pvs, sizeof(built)) != 0;
+#else
+    static GameState open;
+    long differ = 0;
+    open = game;
+    memset(open.pvs, 0xFF, sizeof(open.pvs));
+#endif
+    
+    for (int c = 0; c < RAD_CLUSTERS; c++) {
+        int size = 0;
+        for (int d = 0; d < RAD_CLUSTERS; d++) size += RAD_PVS_HAS(RAD_PVS_OF(&game, c), d);
+        if (size) {
+            clusters += size;
+            sets++;
+        }
+    }
+    
+    for (long n = 0; n < spots; n++) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        int32_t px = (int32_t)(rng % (MAP_W * RAD_FP)), py = (int32_t)((rng >> 16) % (MAP_H * RAD_FP));
+        if (rad_pvs_blocks(game.map[py / RAD_FP][px / RAD_FP])) continue;
+        
+        game.player_x = (uint16_t)px;
+        game.player_y = (uint16_t)py;
+        game.player_angle = (uint8_t)(rng >> 8);
+        const uint8_t* pvs = RAD_PVS_OF(&game, RAD_CLUSTER_AT(px / RAD_FP, py / RAD_FP));
+        int32_t dir_x = rad_cos(game.player_angle), dir_y = rad_sin(game.player_angle);
+        int32_t plane_x = -dir_y * RAD_PLANE / RAD_ONE, plane_y = dir_x * RAD_PLANE / RAD_ONE;
+        for (int x = 0; x < SCREEN_W; x++) {
+            uint8_t seen[RAD_PVS_BYTES] = {0};
+            int32_t cam = 2 * x + 1 - SCREEN_W;
+            rad_pvs_trace(&game, px, py, dir_x + plane_x * cam / SCREEN_W,
+                          dir_y + plane_y * cam / SCREEN_W, seen);
+            for (int b = 0; b < RAD_PVS_BYTES; b++) leaks += (seen[b] & ~pvs[b]) != 0;
+        }
+        
+#ifndef RAD_PVS_BAKED
+        open.player_x = game.player_x;
+        open.player_y = game.player_y;
+        open.player_angle = game.player_angle;
+        render_rad_walls(&game);
+        render_rad_enemies(&game);
+        render_rad_walls(&open);
+        render_rad_enemies(&open);
+        differ += memcmp(game.cells, open.cells, sizeof(game.cells)) != 0;
+#endif
+        
+        RadEnemyMask live = 0, visible = rad_pvs_enemies(&game);
+        for (int c = 0; c < RAD_CLUSTERS; c++) live |= game.cluster_enemies[c];
+        for (int i = 0; i < MAX_ENEMIES; i++) {
+            enemies += (live >> i) & 1;
+            culled += ((live & ~visible) >> i) & 1;
+        }
+    }
+    
+    printf("build_rad_pvs: %7.2f ms/map (%d clusters of %dx%d tiles, %u bytes of sets)\n",
+           elapsed_ns(t0, t1, builds) / 1e6, RAD_CLUSTERS, RAD_CLUSTER, RAD_CLUSTER,
+           (unsigned)sizeof(built));
+    printf("PVS size:      %7.1f of %d clusters on average\n",
+           sets ? (double)clusters / sets : 0.0, RAD_CLUSTERS);
+    printf("enemies culled:%7.1f%% before projection\n", enemies ? 100.0 * culled / enemies : 0.0);
+#ifdef RAD_PVS_BAKED
+    printf("rays leaving their PVS: %ld, baked sets %s\n\n",
+           leaks, stale ? "differ from the map's (rerun make rad-pvs)" : "match the map's");
+#else
+    printf("rays leaving their PVS: %ld, frames differing from an unculled view: %ld\n\n",
+           leaks, differ);
+#endif
+}
+
+// The dithering the lookups replaced: a modulo and a glyph test per cell
+// on alternate rows (kept here as the baseline)
+static void old_dithering(GameState* game) {
+    for (int x = 0; x < SCREEN_W; x++) {
+        int pattern_idx = (game->column_depth[x] / 64) % 4;
+        uint8_t* column = game->cells[x];
+        for (int y = x % 2; y < RAD_VIEW_H; y += 2) {
+            if (RAD_CELL_GLYPH(column[y]) == GLYPH_HASH) {
+                column[y] = RAD_CELL(DITHER_PATTERNS[1][pattern_idx], RAD_CELL_COLOR(column[y]));
+            }
+        }
+    }
+}
+
+// Dithering passes over a set of views: rendered ones, and random cells
+// and depths so every band has '#' to swap. Every path must leave the
+// cells byte for byte as the baseline does.
+#define DITHER_VIEWS 64
+
+static uint8_t dither_views[DITHER_VIEWS][SCREEN_W][RAD_VIEW_H];
+static uint8_t dither_depths[DITHER_VIEWS][SCREEN_W];
+
+static void dither_setup(void) {
+    init_rad_game(&game);
+    for (int v = 0; v < DITHER_VIEWS; v++) {
+        if (v < DITHER_VIEWS / 2) {
+            game.player_angle = (uint8_t)(v * 8);
+            render_rad_walls(&game);
+            render_rad_enemies(&game);
+            memcpy(dither_views[v], game.cells, sizeof(game.cells));
+            memcpy(dither_depths[v], game.column_depth, sizeof(game.column_depth));
+            continue;
+        }
+        for (int x = 0; x < SCREEN_W; x++) {
+            dither_depths[v][x] = (uint8_t)rad_rand(&game);
+            for (int y = 0; y < RAD_VIEW_H; y++) {
+                uint32_t r = rad_rand(&game);
+                dither_views[v][x][y] = RAD_CELL(r % 4 ? GLYPH_HASH : (r >> 8) % GLYPH_COUNT, (r >> 16) & 7);
+            }
+        }
+    }
+}
+
+static double bench_dither(const char* name, void (*dither)(GameState*), double base) {
+    static uint8_t want[DITHER_VIEWS][SCREEN_W][RAD_VIEW_H];
+    const long reps = 50000;
+    bool same = true;
+    
+    for (int v = 0; v < DITHER_VIEWS; v++) {
+        memcpy(game.cells, dither_views[v], sizeof(game.cells));
+        memcpy(game.column_depth, dither_depths[v], sizeof(game.column_depth));
+        if (!base) {
+            old_dithering(&game);
+            memcpy(want[v], game.cells, sizeof(game.cells));
+        }
+        dither(&game);
+        same = same && memcmp(want[v], game.cells, sizeof(game.cells)) == 0;
+    }
+    
+    // Timed on fresh copies of the views, less the cost of copying them in
+    clock_t t0 = clock();
+    for (long n = 0; n < reps; n++) {
+        int v = (int)(n % DITHER_VIEWS);
+        memcpy(game.cells, dither_views[v], sizeof(game.cells));
+        memcpy(game.column_depth, dither_depths[v], sizeof(game.column_depth));
+        sink += game.cells[n % SCREEN_W][n % RAD_VIEW_H];
+    }
+    clock_t t1 = clock();
+    for (long n = 0; n < reps; n++) {
+        int v = (int)(n % DITHER_VIEWS);
+        memcpy(game.cells, dither_views[v], sizeof(game.cells));
+        memcpy(game.column_depth, dither_depths[v], sizeof(game.column_depth));
+        dither(&game);
+        sink += game.cells[n % SCREEN_W][n % RAD_VIEW_H];
+    }
+    clock_t t2 = clock();
+    
+    double ns = elapsed_ns(t1 - t0, t2 - t1, reps);
+    printf("%-14s %7.1f ns/frame  %5.2fx  %s\n", name, ns, base && ns ? base / ns : 1.0,
+           same ? "identical" : "DIFFERS");
+    return ns;
+}
+
+// One full frame: walls, enemies, dithering, particles and HUD
+static void bench_view(void) {
+    const long reps = 20000;
+    
+    init_rad_game(&game);
+    clock_t t0 = clock();
+    for (long n = 0; n < reps; n++) {
+        game.player_angle = (uint8_t)n;
+        render_rad_view(&game);
+        sink = game.cells[n % SCREEN_W][n % RAD_VIEW_H];
+    }
+    clock_t t1 = clock();
+    
+    printf("render_rad_view: %5.2f us/frame (%dx%d)\n",
+           elapsed_ns(t0, t1, reps) / 1000.0, SCREEN_W, SCREEN_H);
+}
+
+int main(void) {
+    printf("RAD-Doom Benchmarks (map %dx%d, view %dx%d)\n", MAP_W, MAP_H, SCREEN_W, RAD_VIEW_H);
+    printf("==============================================\n");
+    printf("GameState:     %u bytes (view cells %u, column depths %u, HUD %u)\n\n",
+           (unsigned)sizeof(GameState), (unsigned)sizeof(game.cells),
+           (unsigned)sizeof(game.column_depth), (unsigned)sizeof(game.hud));
+    
+    long marcher = bench_walls("float marcher", render_float_walls);
+    long dda = bench_walls("integer DDA", render_rad_walls);
+    printf("speedup:       %7.1fx\n\n", dda ? (double)marcher / dda : 0.0);
+    bench_particles("scanned AoS", OLD_PARTICLES, old_spawn, old_frame);
+    bench_particles("pooled SoA", MAX_PARTICLES, new_spawn, new_frame);
+    printf("\n");
+#if RAD_PARALLEL
+    bench_threads();
+#endif
+    bench_pvs();
+    
+    dither_setup();
+    double base = bench_dither("dither (%)", old_dithering, 0);
+    bench_dither("dither (LUT)", rad_dither_scalar, base);
+#if RAD_SIMD
+    bench_dither(RAD_VEC == 32 ? "dither (AVX2)" : RAD_VEC ? "dither (SSE2)" : "dither (short)",
+                 rad_dither_simd, base);
+#endif
+    printf("\n");
+    bench_view();
+    return 0;
+}
@@ -0,0 +1,196 @@
+/*
+ * Text Doom Benchmarks - host-side cost of the game's hot paths
+ * Build per profile (make bench, or add -DUSE_CONFIG_HEADER -DLARGE_WORLD
+ * to CFLAGS; compiled levels link build/levels/level_blobs.c with
+ * -DLEVEL_BLOBS) and compare the numbers before and after a change.
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+// Include the game logic
+#include "../doom/text_doom_game.c"
+
+static GameState game;
+static Frame screen;
+static volatile uint32_t sink;   // Keeps results alive under -O2
+
+// Levels to cycle through: generated levels exist for any number
+#if LEVEL_COMPILED
+#define BENCH_LEVELS LEVEL_COUNT
+#else
+#define BENCH_LEVELS 10
+#endif
+
+static double elapsed_ns(clock_t t0, clock_t t1, long ops) {
+    return (double)(t1 - t0) * 1e9 / CLOCKS_PER_SEC / ops;
+}
+
+// Derive every tile of the map, over many seeds and levels
+static void bench_level_tile(void) {
+    const int levels = MAP_STREAMED ? 20 : 200;
+    long tiles = 0;
+    uint32_t acc = 0;
+    
+    clock_t t0 = clock();
+    for (int n = 0; n < levels; n++) {
+        game.seed = 1 + n;
+        init_level(&game, (uint8_t)(1 + n % BENCH_LEVELS));
+        for (int y = 0; y < MAP_H; y++) {
+            for (int x = 0; x < MAP_W; x++) {
+                acc += level_tile(&game, x, y);
+            }
+        }
+        tiles += MAP_W * MAP_H;
+    }
+    clock_t t1 = clock();
+    sink = acc;
+    
+    printf("level_tile:   %6.1f ns/tile  (%ld tiles)\n", elapsed_ns(t0, t1, tiles), tiles);
+}
+
+// Tiles as the game reads them, walking the map a screen-sized window at a
+// time (the access pattern of render_frame)
+static void bench_map_tile(void) {
+    const int passes = 20;
+    long tiles = 0;
+    uint32_t acc = 0;
+    
+    init_game(&game);
+    clock_t t0 = clock();
+    for (int n = 0; n < passes; n++) {
+        for (int wy = 0; wy < MAP_H; wy += SCREEN_H) {
+            for (int wx = 0; wx < MAP_W; wx += SCREEN_W) {
+                for (int y = wy; y < wy + SCREEN_H && y < MAP_H; y++) {
+                    for (int x = wx; x < wx + SCREEN_W && x < MAP_W; x++) {
+                        acc += map_tile(&game, x, y);
+                        tiles++;
+                    }
+                }
+            }
+        }
+    }
+    clock_t t1 = clock();
+    sink = acc;
+    
+    printf("map_tile:     %6.1f ns/tile", elapsed_ns(t0, t1, tiles));
+#if MAP_STREAMED
+    const MapStreamStats* st = map_stream_get_stats();
+    printf("  (%.1f%% chunk cache hits)", st->lookups ? 100.0 * st->hits / st->lookups : 0.0);
+#endif
+    printf("\n");
+}
+
+// Generate a level descriptor and spawn its enemies
+static void bench_init_level(void) {
+    const long reps = MAP_STREAMED ? 200 : 100000;
+    
+    clock_t t0 = clock();
+    for (long n = 0; n < reps; n++) {
+        game.seed = (uint32_t)n + 1;
+        init_level(&game, (uint8_t)(1 + n % BENCH_LEVELS));
+    }
+    clock_t t1 = clock();
+    sink = game.layout.room_count;
+    
+    printf("init_level:   %6.1f ns/level\n", elapsed_ns(t0, t1, reps));
+}
+
+#if LEVEL_COMPILED
+// Decompress the walls of every level, a row at a time into a level-sized
+// bitset (what load_level() does on the card)
+static void bench_decode_walls(void) {
+    static uint8_t walls[LEVEL_WALL_RAM];
+    const long reps = 200000;
+    long rows = 0, in = 0, out = 0;
+    
+    clock_t t0 = clock();
+    for (long n = 0; n < reps; n++) {
+        const uint8_t* blob = level_blobs[n % LEVEL_COUNT];
+        LevelBits bits = {level_blob_section(blob, LEVEL_BLOB_WALLS), 0};
+        int bytes = LEVEL_ROW_BYTES(blob[LB_W]);
+        for (int y = 0; y < blob[LB_H]; y++) level_decode_row(&bits, walls + y * bytes, blob[LB_W]);
+        rows += blob[LB_H];
+        out += blob[LB_H] * bytes;
+        if (n < LEVEL_COUNT) in += ((bits.pos + 7) >> 3) + 1;
+    }
+    clock_t t1 = clock();
+    sink = walls[LEVEL_WALL_RAM / 2];
+    
+    double secs = (double)(t1 - t0) / CLOCKS_PER_SEC;
+    printf("decode_walls: %6.1f ns/row    (%.1f MB/s out, %ld bytes in ROM for %ld)\n",
+           elapsed_ns(t0, t1, rows), secs > 0 ? out / secs / 1e6 : 0.0,
+           in, out / reps * LEVEL_COUNT);
+}
+#endif
+
+// Simulation ticks with no input (enemy AI and bullets)
+static void bench_update(void) {
+    const long reps = 200000;
+    long ticks = 0;
+    
+    clock_t t0 = clock();
+    for (long n = 0; n < reps; n++) {
+        if (n % 200 == 0) init_game_seeded(&game, (uint32_t)n + 1);
+        if (game.game_over) continue;
+        update_game(&game);
+        ticks++;
+    }
+    clock_t t1 = clock();
+    sink = game.frame_count;
+    
+    printf("update_game:  %6.1f ns/tick  (%ld ticks)\n", elapsed_ns(t0, t1, ticks ? ticks : 1), ticks);
+}
+
+// One full frame of map + entities + status into the frame, at the
+// profile's own size and (host builds) the smallest and largest viewports
+static void bench_render(void) {
+#if RUNTIME_VIEWPORT
+    static const uint8_t sizes[][2] = {
+        {SCREEN_W, SCREEN_H}, {VIEW_MIN_W, VIEW_MIN_H}, {VIEW_MAX_W, VIEW_MAX_H}
+    };
+#else
+    static const uint8_t sizes[][2] = {{SCREEN_W, SCREEN_H}};
+    static uint8_t cells[SCREEN_H][SCREEN_W];
+    screen = (Frame){&cells[0][0], SCREEN_W, SCREEN_W, SCREEN_H};
+#endif
+    const long reps = 20000;
+    
+    init_game(&game);
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) {
+#if RUNTIME_VIEWPORT
+        set_viewport(sizes[s][0], sizes[s][1]);
+        frame_alloc(&screen);
+#endif
+        
+        clock_t t0 = clock();
+        for (long n = 0; n < reps; n++) {
+            render_frame(&game, &screen);
+            sink = FRAME_AT(&screen, n % screen.w, n % screen.h);
+        }
+        clock_t t1 = clock();
+        
+        printf("render_frame: %6.1f us/frame (%dx%d, %.2f ns/cell)\n",
+               elapsed_ns(t0, t1, reps) / 1000.0, screen.w, screen.h,
+               elapsed_ns(t0, t1, reps * screen.w * screen.h));
+    }
+}
+
+int main(void) {
+    printf("Text Doom Benchmarks (%s profile, map %dx%d)\n", MEMORY_SIZE_STR, MAP_W, MAP_H);
+    printf("==============================================\n");
+    printf("Level RAM:    %u bytes descriptor + edits (stored map: %u)\n",
+           (unsigned)(sizeof(LevelDesc) + sizeof(PickupMask) + sizeof(DoorMask)),
+           (unsigned)(MAP_W * MAP_H));
+    printf("GameState:    %u bytes\n\n", (unsigned)sizeof(GameState));
+    
+    bench_level_tile();
+    bench_map_tile();
+    bench_init_level();
+#if LEVEL_COMPILED
+    bench_decode_walls();
+#endif
+    bench_update();
+    bench_render();
+    return 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * Memory Report - where a profile's RAM goes
+ * Prints the field-by-field layout of the game state (offsets, sizes and
+ * any alignment padding) and the applet's RAM total against the profile's
+ * budget. make memory-report builds and runs it for every profile.
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+
+// Include the SIM application (game, save states, RAM accounting)
+#include "../sim/sim_game_main.c"
+
+typedef struct {
+    const char* name;
+    size_t offset;
+    size_t size;
+} FieldInfo;
+
+#define FIELD(type, f) {#f, offsetof(type, f), sizeof(((type*)0)->f)}
+
+// Print 'fields' (in declaration order) with the padding between them
+static size_t print_layout(const char* type_name, size_t type_size,
+                           const FieldInfo* fields, int count) {
+    size_t end = 0, padding = 0;
+    
+    printf("%-22s offset  bytes\n", type_name);
+    for (int i = 0; i < count; i++) {
+        if (fields[i].offset > end) {
+            printf("  %-20s         %5zu\n", "(padding)", fields[i].offset - end);
+            padding += fields[i].offset - end;
+        }
+        printf("  %-20s %6zu  %5zu\n", fields[i].name, fields[i].offset, fields[i].size);
+        end = fields[i].offset + fields[i].size;
+    }
+    if (type_size > end) {
+        printf("  %-20s         %5zu\n", "(tail padding)", type_size - end);
+        padding += type_size - end;
+    }
+    printf("  %-20s         %5zu  (%zu padding)\n\n", "total", type_size, padding);
+    return padding;
+}
+
+int main(int argc, char** argv) {
+    // Bit-fields have no offset; they are listed as the byte they share
+    static const FieldInfo game_fields[] = {
+        FIELD(GameState, seed),
+        FIELD(GameState, rng),
+        FIELD(GameState, build_rng),
+        FIELD(GameState, pickups_taken),
+        FIELD(GameState, doors_open),
+        FIELD(GameState, enemies),
+        FIELD(GameState, bullets),
+        FIELD(GameState, player_x),
+        FIELD(GameState, player_y),
+        FIELD(GameState, player_angle),
+        FIELD(GameState, frame_count),
+        FIELD(GameState, build_pos),
+        FIELD(GameState, health),
+        FIELD(GameState, ammo),
+        FIELD(GameState, level),
+        FIELD(GameState, build_stage),
+        FIELD(GameState, weapon),
+#if ADAPTIVE_CAPACITY
+        FIELD(GameState, enemy_cap),
+        FIELD(GameState, bullet_cap),
+#endif
+        {"game_over, victory", offsetof(GameState, layout) - 1, 1},
+        FIELD(GameState, layout),
+    };
+    static const FieldInfo enemy_fields[] = {
+        FIELD(EnemyPool, x),
+        FIELD(EnemyPool, y),
+        FIELD(EnemyPool, health),
+        FIELD(EnemyPool, live),
+        FIELD(EnemyPool, idle),
+        FIELD(EnemyPool, coarse),
+        FIELD(EnemyPool, dormant),
+        FIELD(EnemyPool, wake),
+    };
+    static const FieldInfo bullet_fields[] = {
+        FIELD(BulletPool, x),
+        FIELD(BulletPool, y),
+        FIELD(BulletPool, dx),
+        FIELD(BulletPool, dy),
+        FIELD(BulletPool, live),
+    };
+    static const FieldInfo level_fields[] = {
+#if LEVEL_COMPILED
+        FIELD(LevelDesc, doors),
+        FIELD(LevelDesc, pickups),
+        FIELD(LevelDesc, w),
+        FIELD(LevelDesc, h),
+        FIELD(LevelDesc, exit_x),
+        FIELD(LevelDesc, exit_y),
+        FIELD(LevelDesc, room_count),
+        FIELD(LevelDesc, door_count),
+        FIELD(LevelDesc, pickup_count),
+#else
+        FIELD(LevelDesc, rooms),
+        FIELD(LevelDesc, doors),
+        FIELD(LevelDesc, pickups),
+        FIELD(LevelDesc, room_count),
+#endif
+    };
+    
+    // "summary": just the totals (used for the packed variant)
+    if (argc > 1) {
+        (void)argv;
+        printf("%-10s GameState %4zu bytes, applet %5zu of %5d bytes\n",
+               MEMORY_SIZE_STR, sizeof(GameState), (size_t)RAM_TOTAL, RAM_BUDGET);
+        return 0;
+    }
+    
+    printf("=== %s profile (map %dx%d, %d enemies, %d bullets%s) ===\n\n",
+           MEMORY_SIZE_STR, MAP_W, MAP_H, MAX_ENEMIES, MAX_BULLETS,
+           ADAPTIVE_CAPACITY ? " max" : "");
+    print_layout("GameState", sizeof(GameState), game_fields,
+                 (int)(sizeof(game_fields) / sizeof(game_fields[0])));
+    print_layout("EnemyPool", sizeof(EnemyPool), enemy_fields,
+                 (int)(sizeof(enemy_fields) / sizeof(enemy_fields[0])));
+    print_layout("BulletPool", sizeof(BulletPool), bullet_fields,
+                 (int)(sizeof(bullet_fields) / sizeof(bullet_fields[0])));
+    print_layout("LevelDesc", sizeof(LevelDesc), level_fields,
+                 (int)(sizeof(level_fields) / sizeof(level_fields[0])));
+    
+    printf("Applet RAM                    bytes\n");
+    printf("  %-26s %5zu\n", "game state", (size_t)RAM_GAME_STATE);
+    printf("  %-26s %5zu\n", "persistent arena", (size_t)ARENA_PERSISTENT_SIZE);
+    printf("  %-26s %5zu\n", "level arena", (size_t)ARENA_LEVEL_SIZE);
+    printf("  %-26s %5zu\n", "transient arena", (size_t)ARENA_TRANSIENT_SIZE);
+    printf("  %-26s %5zu\n", "NVM write cache", (size_t)RAM_NVM_CACHE);
+    printf("  %-26s %5zu\n", "APDU buffers", (size_t)RAM_APDU_BUFFERS);
+    printf("  %-26s %5zu\n", "map chunk cache", (size_t)RAM_MAP_CACHE);
+    printf("  %-26s %5zu\n", "stack allowance", (size_t)SIM_APP_STACK);
+    printf("  %-26s %5zu of %d (%zu%%)\n\n", "total", (size_t)RAM_TOTAL, RAM_BUDGET,
+           (size_t)(RAM_TOTAL * 100 / RAM_BUDGET));
+    return 0;
+}
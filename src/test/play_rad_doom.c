@@ -36,6 +36,20 @@
 // RAD-style dithering patterns
 const char DITHER_CHARS[] = " .:-=+*#%@";
 
+// Display-only effects draw from their own xorshift stream so they never
+// consume (or depend on) the simulation's seeded PRNG
+static uint32_t fx_rng = 0x2545F491u;
+
+// Last rendered frame (effects are drawn over it)
+static Frame screen;
+
+static uint32_t fx_rand(void) {
+    fx_rng ^= fx_rng << 13;
+    fx_rng ^= fx_rng >> 17;
+    fx_rng ^= fx_rng << 5;
+    return fx_rng;
+}
+
 // Enhanced display with color and dithering
 void display_rad_screen(const GameState* game) {
     system("clear");
@@ -45,9 +59,9 @@ void display_rad_screen(const GameState* game) {
     printf(COL_YELLOW "(%s Edition)" COL_RESET "\n\n", MEMORY_SIZE_STR);
     
     // Game screen with dithering effects
-    for (int y = 0; y < SCREEN_H; y++) {
-        for (int x = 0; x < SCREEN_W; x++) {
-            char c = game->screen[y][x];
+    for (int y = 0; y < screen.h; y++) {
+        for (int x = 0; x < screen.w; x++) {
+            char c = FRAME_AT(&screen, x, y);
             
             // Apply color based on character
             if (ENABLE_COLOR) {
@@ -197,8 +211,14 @@ int main() {
     printf("\nPress any key to start...");
     getchar();
     
-    // Initialize game
+    // Initialize game (and the frame it renders into, at the default viewport)
     init_game(&game);
+#if RUNTIME_VIEWPORT
+    frame_alloc(&screen);
+#else
+    static uint8_t cells[SCREEN_H][SCREEN_W];
+    screen = (Frame){&cells[0][0], SCREEN_W, SCREEN_W, SCREEN_H};
+#endif
     
     // Game loop
     bool running = true;
@@ -208,23 +228,20 @@ int main() {
         // Display
         display_rad_screen(&game);
         
-        // Update game
-        update_game(&game);
-        render_game(&game);
-        
         // Handle input
+        char key = 0;
         if (kbhit()) {
-            char key = getchar();
+            key = getchar();
             
             if (key == 27) {  // ESC
                 running = false;
-            } else if (key == 'r' && game.game_over) {
-                init_game(&game);
-            } else {
-                process_game_input(&game, key);
             }
         }
         
+        // Advance one fixed tick, then render
+        step_game(&game, key == 27 ? 0 : key);
+        render_frame(&game, &screen);
+        
         // Frame rate control (targeting ~20 FPS for smoothness)
         usleep(50000);  // 50ms
         frame++;
@@ -233,10 +250,10 @@ int main() {
         if (frame % 5 == 0 && ENABLE_PARTICLES) {
             // Simulate particle effects by adding dots to empty spaces
             for (int i = 0; i < 3; i++) {
-                int y = rand() % SCREEN_H;
-                int x = rand() % SCREEN_W;
-                if (game.screen[y][x] == ' ') {
-                    game.screen[y][x] = '.';
+                int y = fx_rand() % screen.h;
+                int x = fx_rand() % screen.w;
+                if (FRAME_AT(&screen, x, y) == ' ') {
+                    FRAME_AT(&screen, x, y) = '.';
                 }
             }
         }
@@ -0,0 +1,78 @@
+/*
+ * Play RAD-Doom Engine - first-person launcher
+ * Drives the integer raycaster in rad_doom_enhanced.c from the keyboard
+ */
+
+#define _DEFAULT_SOURCE  // usleep and sysconf under -std=c99
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <termios.h>
+#include <fcntl.h>
+
+// Use the first-person engine
+#include "../doom/rad_doom_enhanced.c"
+
+// Non-blocking input
+int kbhit(void) {
+    struct termios oldt, newt;
+    int ch;
+    int oldf;
+    
+    tcgetattr(STDIN_FILENO, &oldt);
+    newt = oldt;
+    newt.c_lflag &= ~(ICANON | ECHO);
+    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
+    oldf = fcntl(STDIN_FILENO, F_GETFL, 0);
+    fcntl(STDIN_FILENO, F_SETFL, oldf | O_NONBLOCK);
+    
+    ch = getchar();
+    
+    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
+    fcntl(STDIN_FILENO, F_SETFL, oldf);
+    
+    if(ch != EOF) {
+        ungetc(ch, stdin);
+        return 1;
+    }
+    
+    return 0;
+}
+
+// Main game loop
+int main(void) {
+    static GameState game;
+    
+    init_rad_game(&game);
+#if RAD_PARALLEL
+    rad_pool_start((int)sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+    
+    while (!game.game_over) {
+        render_rad_view(&game);
+        display_rad_screen(&game);
+        printf(COL_DIM "WS=move AD=strafe QE=turn SPC=fire 1-4=weapon ESC=quit\n" COL_RESET);
+        
+        // Handle input
+        char key = 0;
+        if (kbhit()) {
+            key = getchar();
+            if (key == 27) break;  // ESC
+        }
+        
+        // Advance one fixed tick (~20 FPS)
+        step_rad_game(&game, key);
+        usleep(50000);
+    }
+    
+#if RAD_PARALLEL
+    rad_pool_stop();
+#endif
+    
+    if (game.victory) {
+        printf(COL_BRIGHT COL_GREEN "\nYou found the exit!\n" COL_RESET);
+    }
+    printf("Kills: %d  Secrets: %d/%d\n", game.kills, game.secrets_found, game.secrets_total);
+    return 0;
+}
@@ -16,11 +16,19 @@
 #include <unistd.h>
 #include <termios.h>
 #include <fcntl.h>
+#include <sys/ioctl.h>
 #endif
 
 // Include the game logic
 #include "../doom/text_doom_game.c"
 
+// Last rendered frame
+static Frame screen;
+
+// Terminal lines and columns display_game() draws around the frame
+#define DISPLAY_CHROME_W 2      // Border
+#define DISPLAY_CHROME_H 11     // Title, border, legend and restart prompt
+
 // Platform-specific functions
 void clear_screen() {
 #ifdef _WIN32
@@ -71,26 +79,22 @@ void display_game(GameState* game) {
     
     // Draw border
     printf("+");
-    for (int i = 0; i < SCREEN_W; i++) printf("-");
+    for (int i = 0; i < screen.w; i++) printf("-");
     printf("+\n");
     
     // Draw game screen
-    for (int y = 0; y < SCREEN_H; y++) {
-        printf("|");
-        for (int x = 0; x < SCREEN_W; x++) {
-            printf("%c", game->screen[y][x]);
-        }
-        printf("|\n");
+    for (int y = 0; y < screen.h; y++) {
+        printf("|%.*s|\n", screen.w, (const char*)&FRAME_AT(&screen, 0, y));
     }
     
     // Draw bottom border
     printf("+");
-    for (int i = 0; i < SCREEN_W; i++) printf("-");
+    for (int i = 0; i < screen.w; i++) printf("-");
     printf("+\n");
     
     // Legend
     printf("\nLEGEND: @ = You, E = Enemy, * = Bullet\n");
-    printf("        # = Wall, X = Exit, a = Ammo, + = Health\n");
+    printf("        # = Wall, D = Door, X = Exit, a = Ammo, + = Health\n");
     printf("        ^ > v < = Your facing direction\n");
     
     if (game->game_over) {
@@ -98,14 +102,54 @@ void display_game(GameState* game) {
     }
 }
 
+#if RUNTIME_VIEWPORT
+// Viewport for this run: "-s WxH" if given, else as much of the terminal
+// as the display chrome leaves, else the profile's default
+static void choose_viewport(int argc, char** argv) {
+    int w = 0, h = 0;
+    
+    if (argc > 2 && strcmp(argv[1], "-s") == 0) {
+        if (sscanf(argv[2], "%dx%d", &w, &h) != 2 || !set_viewport(w, h)) {
+            printf("Screen size must be %dx%d to %dx%d; using %dx%d\n",
+                   VIEW_MIN_W, VIEW_MIN_H, VIEW_MAX_W, VIEW_MAX_H, SCREEN_W, SCREEN_H);
+        }
+        return;
+    }
+#ifndef _WIN32
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col && ws.ws_row) {
+        w = ws.ws_col - DISPLAY_CHROME_W;
+        h = ws.ws_row - DISPLAY_CHROME_H;
+        set_viewport(w < VIEW_MAX_W ? w : VIEW_MAX_W,
+                     h < VIEW_MAX_H ? h : VIEW_MAX_H);  // Too small: keep the default
+    }
+#endif
+}
+#endif
+
 // Main game loop
-int main() {
+int main(int argc, char** argv) {
     GameState* game = malloc(sizeof(GameState));
     if (!game) {
         printf("Failed to allocate game state!\n");
         return 1;
     }
     
+    // Size the frame to the viewport (card-kernel builds: the fixed screen)
+#if RUNTIME_VIEWPORT
+    choose_viewport(argc, argv);
+    if (!frame_alloc(&screen)) {
+        printf("Failed to allocate the frame!\n");
+        free(game);
+        return 1;
+    }
+#else
+    static uint8_t cells[SCREEN_H][SCREEN_W];
+    screen = (Frame){&cells[0][0], SCREEN_W, SCREEN_W, SCREEN_H};
+    (void)argc;
+    (void)argv;
+#endif
+    
     printf("=== TEXT DOOM ===\n");
     printf("A complete Doom-like game in pure ASCII\n");
     printf("Fits in 8KB of memory!\n\n");
@@ -113,6 +157,7 @@ int main() {
     printf("  W/A/S/D = Move\n");
     printf("  Q/E = Turn left/right\n");
     printf("  SPACE = Fire\n");
+    printf("  F = Switch weapon\n");
     printf("  ESC = Quit\n\n");
     printf("Find the exit (X) while avoiding enemies (E)!\n");
     printf("Collect ammo (a) and health (+) to survive!\n\n");
@@ -128,28 +173,22 @@ int main() {
     int frame_counter = 0;
     
     while (running) {
-        // Update game logic
-        update_game(game);
-        
-        // Render
-        render_game(game);
-        display_game(game);
-        
-        // Check for input (non-blocking)
+        // Gather this tick's input (0 = no key)
+        char input = 0;
         if (kbhit()) {
-            char input = getch();
+            input = getch();
             
-            if (input == 27 || input == 'Q') {  // ESC or Q to quit
-                if (game->game_over || input == 27) {
-                    running = false;
-                } else {
-                    turn_player(game, -1);  // Q turns left in-game
-                }
-            } else {
-                process_game_input(game, input);
+            if (input == 27 || (input == 'Q' && game->game_over)) {  // ESC, or Q once dead
+                running = false;
+                break;
             }
         }
         
+        // Advance one fixed tick, then render
+        step_game(game, input);
+        render_frame(game, &screen);
+        display_game(game);
+        
         // Frame rate limiting (approximately 10 FPS)
 #ifdef _WIN32
         Sleep(100);
@@ -6,122 +6,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
-// Don't define TEST_BUILD to avoid main() conflict
-// We'll provide our own stubs
-
-// Include the game logic
-#include "../doom/text_doom_game.c"
-
-// APDU definitions
-#define CLA_DOOM            0x80
-#define INS_INIT_GAME       0x01
-#define INS_PROCESS_INPUT   0x02
-#define INS_UPDATE_GAME     0x03
-#define INS_GET_SCREEN      0x04
-#define INS_GET_STATUS      0x05
-
-// Global game state
-static GameState game;
-static bool initialized = false;
-
-// Include just the process_apdu function
-void process_apdu(const uint8_t* cmd, uint16_t cmd_len, 
-                  uint8_t* resp, uint16_t* resp_len) {
-    if (cmd_len < 4) {
-        resp[0] = 0x67;
-        resp[1] = 0x00;
-        *resp_len = 2;
-        return;
-    }
-    
-    uint8_t cla = cmd[0];
-    uint8_t ins = cmd[1];
-    
-    if (cla != CLA_DOOM) {
-        resp[0] = 0x6E;
-        resp[1] = 0x00;
-        *resp_len = 2;
-        return;
-    }
-    
-    switch (ins) {
-        case INS_INIT_GAME:
-            init_game(&game);
-            initialized = true;
-            resp[0] = 0x90;
-            resp[1] = 0x00;
-            *resp_len = 2;
-            break;
-            
-        case INS_PROCESS_INPUT:
-            if (!initialized || cmd_len < 5) {
-                resp[0] = 0x67;
-                resp[1] = 0x00;
-                *resp_len = 2;
-                break;
-            }
-            process_game_input(&game, cmd[4]);
-            resp[0] = 0x90;
-            resp[1] = 0x00;
-            *resp_len = 2;
-            break;
-            
-        case INS_UPDATE_GAME:
-            if (!initialized) {
-                resp[0] = 0x69;
-                resp[1] = 0x86;
-                *resp_len = 2;
-                break;
-            }
-            update_game(&game);
-            render_game(&game);
-            resp[0] = 0x90;
-            resp[1] = 0x00;
-            *resp_len = 2;
-            break;
-            
-        case INS_GET_SCREEN:
-            if (!initialized) {
-                resp[0] = 0x69;
-                resp[1] = 0x86;
-                *resp_len = 2;
-                break;
-            }
-            memcpy(resp, game.screen, SCREEN_W * SCREEN_H);
-            resp[SCREEN_W * SCREEN_H] = 0x90;
-            resp[SCREEN_W * SCREEN_H + 1] = 0x00;
-            *resp_len = SCREEN_W * SCREEN_H + 2;
-            break;
-            
-        case INS_GET_STATUS:
-            if (!initialized) {
-                resp[0] = 0x69;
-                resp[1] = 0x86;
-                *resp_len = 2;
-                break;
-            }
-            resp[0] = game.health;
-            resp[1] = game.ammo;
-            resp[2] = game.level;
-            resp[3] = game.game_over ? 1 : 0;
-            resp[4] = game.victory ? 1 : 0;
-            resp[5] = 0x90;
-            resp[6] = 0x00;
-            *resp_len = 7;
-            break;
-            
-        default:
-            resp[0] = 0x6D;
-            resp[1] = 0x00;
-            *resp_len = 2;
-            break;
-    }
-}
+// Don't define TEST_BUILD to avoid main() conflict: we pull in the real
+// SIM application (and its process_apdu) and drive it directly
+#include "../sim/sim_game_main.c"
+#include "sim_doom.h"
 
 // Test APDU commands
 void test_apdu_command(const char* name, uint8_t* cmd, uint16_t cmd_len) {
-    uint8_t resp[1024];
+    uint8_t resp[SCREEN_W * SCREEN_H + 2];
     uint16_t resp_len = 0;
     
     printf("\n=== Testing: %s ===\n", name);
@@ -161,14 +55,153 @@ void display_screen(uint8_t* screen_data) {
     printf("+\n");
 }
 
+static uint32_t apdu_state_hash(void) {
+    uint8_t cmd[4] = {CLA_DOOM, INS_GET_STATE_HASH, 0x00, 0x00};
+    uint8_t resp[16];
+    uint16_t resp_len;
+    
+    process_apdu(cmd, 4, resp, &resp_len);
+    return ((uint32_t)resp[0] << 24) | ((uint32_t)resp[1] << 16) |
+           ((uint32_t)resp[2] << 8) | resp[3];
+}
+
+// Replay an input script ('.' = no key) from a seed through the APDU
+// interface, recording the simulation hash after every tick
+#define REPLAY_SCRIPT "wwdd dd..ss eeww  qq..ddwwww . .sssaa  ee.."
+#define REPLAY_TICKS  (sizeof(REPLAY_SCRIPT) - 1)
+
+static void replay_script(uint16_t seed, uint32_t* hashes) {
+    uint8_t cmd[8];
+    uint8_t resp[16];
+    uint16_t resp_len;
+    
+    cmd[0] = CLA_DOOM;
+    cmd[1] = INS_INIT_GAME;
+    cmd[2] = (uint8_t)(seed >> 8);
+    cmd[3] = (uint8_t)seed;
+    process_apdu(cmd, 4, resp, &resp_len);
+    
+    for (size_t t = 0; t < REPLAY_TICKS; t++) {
+        if (REPLAY_SCRIPT[t] != '.') {
+            cmd[1] = INS_PROCESS_INPUT;
+            cmd[2] = 0x00;
+            cmd[3] = 0x00;
+            cmd[4] = 0x01;
+            cmd[5] = (uint8_t)REPLAY_SCRIPT[t];
+            process_apdu(cmd, 6, resp, &resp_len);
+        }
+        cmd[1] = INS_UPDATE_GAME;
+        process_apdu(cmd, 4, resp, &resp_len);
+        
+        hashes[t] = apdu_state_hash();
+    }
+}
+
+// Fetch the screen with GET_SCREEN (P2 = rows per response) and chained
+// GET RESPONSE. Returns the bytes received, and how many responses they
+// took and the largest of them.
+static uint16_t apdu_get_screen(uint8_t rows, uint8_t* frame, uint16_t cap,
+                                int* responses, uint16_t* largest) {
+    uint8_t cmd[5] = {CLA_DOOM, INS_GET_SCREEN, 0x00, rows, 0x00};
+    static uint8_t resp[SCREEN_W * SCREEN_H + 2];
+    uint16_t resp_len, got = 0;
+    
+    *responses = 0;
+    *largest = 0;
+    process_apdu(cmd, 5, resp, &resp_len);
+    for (;;) {
+        uint16_t n = resp_len - 2;
+        (*responses)++;
+        if (n > *largest) *largest = n;
+        if (resp_len < 2 || got + n > cap) return got;
+        memcpy(&frame[got], resp, n);
+        got += n;
+        if (resp[n] != 0x61) return got;
+        cmd[0] = 0x00;
+        cmd[1] = INS_GET_RESPONSE;
+        cmd[3] = 0x00;
+        cmd[4] = resp[n + 1];
+        process_apdu(cmd, 5, resp, &resp_len);
+    }
+}
+
+// The floor tiles of the current level furthest apart along x ('axis' 0)
+// or y: the first on the lowest line holding floor and the first on the
+// highest. Returns the lines between them, or -1 if there is no floor.
+static int floor_span(int axis, int* ax, int* ay, int* bx, int* by) {
+    int lines = axis ? MAP_H : MAP_W, across = axis ? MAP_W : MAP_H;
+    int lo = -1, hi = -1;
+    
+    for (int l = 0; l < lines; l++) {
+        for (int c = 0; c < across; c++) {
+            int x = axis ? c : l, y = axis ? l : c;
+            if (map_tile(&game, x, y) != TILE_EMPTY) continue;
+            if (lo < 0) {
+                *ax = x;
+                *ay = y;
+                lo = l;
+            }
+            *bx = x;
+            *by = y;
+            hi = l;
+            break;
+        }
+    }
+    return lo < 0 ? -1 : hi - lo;
+}
+
+#if HAS_SAVE_STATES
+// Pull a full snapshot with chained SAVE_STATE commands
+static uint16_t apdu_save_snapshot(uint8_t* snap, uint16_t cap) {
+    uint8_t cmd[5] = {CLA_DOOM, INS_SAVE_STATE, 0x00, 0x00, 0x00};
+    uint8_t resp[SCREEN_W * SCREEN_H + 2];
+    uint16_t resp_len, total = 0;
+    
+    for (;;) {
+        cmd[2] = (uint8_t)(total >> 8);
+        cmd[3] = (uint8_t)total;
+        process_apdu(cmd, 5, resp, &resp_len);
+        
+        uint16_t n = resp_len - 2;
+        uint8_t sw1 = resp[n];
+        if ((sw1 != 0x90 && sw1 != 0x61) || total + n > cap) return 0;
+        memcpy(&snap[total], resp, n);
+        total += n;
+        if (sw1 == 0x90) return total;
+    }
+}
+
+// Push a snapshot back in 'chunk'-byte LOAD_STATE commands
+static bool apdu_load_snapshot(const uint8_t* snap, uint16_t len, uint8_t chunk) {
+    uint8_t cmd[5 + 255];
+    uint8_t resp[16];
+    uint16_t resp_len;
+    
+    for (uint16_t off = 0; off < len; off += chunk) {
+        uint8_t n = (uint8_t)(len - off < chunk ? len - off : chunk);
+        cmd[0] = CLA_DOOM;
+        cmd[1] = INS_LOAD_STATE;
+        cmd[2] = (uint8_t)(off >> 8);
+        cmd[3] = (uint8_t)off;
+        cmd[4] = n;
+        memcpy(&cmd[5], &snap[off], n);
+        process_apdu(cmd, 5 + n, resp, &resp_len);
+        if (resp[0] != 0x90 || resp[1] != 0x00) return false;
+    }
+    return true;
+}
+#endif
+
 int main() {
     printf("Text Doom SIM APDU Test Harness\n");
     printf("================================\n");
     printf("This tests the SIM application without hardware\n\n");
     
     uint8_t cmd[256];
-    uint8_t resp[1024];
+    uint8_t resp[SCREEN_W * SCREEN_H + 2];
     uint16_t resp_len;
+    uint16_t largest;
+    int failures = 0, responses;
     
     // Test 1: Initialize game
     cmd[0] = CLA_DOOM;
@@ -178,14 +211,7 @@ int main() {
     test_apdu_command("INIT_GAME", cmd, 4);
     
     // Test 2: Get initial screen
-    cmd[0] = CLA_DOOM;
-    cmd[1] = INS_GET_SCREEN;
-    cmd[2] = 0x00;
-    cmd[3] = 0x00;
-    cmd[4] = 0x00;  // Le
-    
-    process_apdu(cmd, 5, resp, &resp_len);
-    if (resp_len >= SCREEN_W * SCREEN_H + 2) {
+    if (apdu_get_screen(0, resp, sizeof(resp), &responses, &largest) == SCREEN_W * SCREEN_H) {
         display_screen(resp);
     }
     
@@ -214,14 +240,7 @@ int main() {
     }
     
     // Test 4: Get screen after movement
-    cmd[0] = CLA_DOOM;
-    cmd[1] = INS_GET_SCREEN;
-    cmd[2] = 0x00;
-    cmd[3] = 0x00;
-    cmd[4] = 0x00;
-    
-    process_apdu(cmd, 5, resp, &resp_len);
-    if (resp_len >= SCREEN_W * SCREEN_H + 2) {
+    if (apdu_get_screen(0, resp, sizeof(resp), &responses, &largest) == SCREEN_W * SCREEN_H) {
         display_screen(resp);
     }
     
@@ -242,6 +261,1014 @@ int main() {
         printf("Victory: %s\n", resp[4] ? "Yes" : "No");
     }
     
+    // Test 6: Deterministic replay - same seed and inputs, same hashes
+    {
+        uint32_t first[REPLAY_TICKS], second[REPLAY_TICKS];
+        size_t diverged = REPLAY_TICKS;
+        
+        replay_script(0x1234, first);
+        replay_script(0x1234, second);
+        for (size_t t = 0; t < REPLAY_TICKS; t++) {
+            if (first[t] != second[t]) { diverged = t; break; }
+        }
+        
+        // Every bit of a position counts, however wide coord_t is
+        static GameState wide;
+        wide = game;
+        wide.player_x = (coord_t)(wide.player_x ^ ((coord_t)1 << (sizeof(coord_t) * 8 - 2)));
+        bool widths = game_state_hash(&wide) != game_state_hash(&game);
+        
+        printf("\n=== Deterministic Replay ===\n");
+        printf("Ticks: %zu, final hash: %08X\n", REPLAY_TICKS, first[REPLAY_TICKS - 1]);
+        if (!widths) {
+            printf("Hash misses the high bits of a %d-bit position (Error)\n", COORD_BITS);
+            failures++;
+        }
+        if (diverged == REPLAY_TICKS) {
+            printf("Replay matches (Success)\n");
+        } else {
+            printf("Replay diverged at tick %zu (Error)\n", diverged);
+            failures++;
+        }
+    }
+    
+#if HAS_SAVE_STATES
+    // Test 7: Save state, play on, restore, and replay to the same result
+    {
+        uint8_t snap[SNAPSHOT_MAX];
+        uint8_t step[6] = {CLA_DOOM, INS_PROCESS_INPUT, 0x00, 0x00, 0x01, 'w'};
+        uint8_t tick[4] = {CLA_DOOM, INS_UPDATE_GAME, 0x00, 0x00};
+        const char* moves = "ww  dd ssee";
+        uint32_t saved_hash, after_hash;
+        const int reps = 1000;
+        
+        printf("\n=== Save States ===\n");
+        saved_hash = apdu_state_hash();
+        uint16_t len = apdu_save_snapshot(snap, sizeof(snap));
+        
+        for (int i = 0; moves[i]; i++) {
+            step[5] = (uint8_t)moves[i];
+            process_apdu(step, 6, resp, &resp_len);
+            process_apdu(tick, 4, resp, &resp_len);
+        }
+        after_hash = apdu_state_hash();
+        
+        // Restore in small chunks to exercise multi-APDU transfers
+        bool loaded = len > 0 && apdu_load_snapshot(snap, len, 32);
+        bool restored = loaded && apdu_state_hash() == saved_hash;
+        for (int i = 0; restored && moves[i]; i++) {
+            step[5] = (uint8_t)moves[i];
+            process_apdu(step, 6, resp, &resp_len);
+            process_apdu(tick, 4, resp, &resp_len);
+        }
+        bool replayed = restored && apdu_state_hash() == after_hash;
+        
+        // Corrupted snapshots must be rejected, leaving the running game
+        // as it was and still playable
+        const uint16_t bad[2] = {(uint16_t)(len / 2), (uint16_t)(len - 1)};   // A record, the hash
+        uint32_t running = apdu_state_hash();
+        bool rejected = true;
+        for (int k = 0; k < 2; k++) {
+            snap[bad[k]] ^= 0x5A;
+            rejected = rejected && !apdu_load_snapshot(snap, len, 64) && apdu_state_hash() == running;
+            snap[bad[k]] ^= 0x5A;
+        }
+        process_apdu(tick, 4, resp, &resp_len);
+        rejected = rejected && resp_len == 2 && resp[0] == 0x90;
+        apdu_load_snapshot(snap, len, 255);
+        
+        clock_t t0 = clock();
+        for (int i = 0; i < reps; i++) apdu_save_snapshot(snap, sizeof(snap));
+        clock_t t1 = clock();
+        for (int i = 0; i < reps; i++) apdu_load_snapshot(snap, len, 255);
+        clock_t t2 = clock();
+        
+        printf("Snapshot size: %u bytes (max %u, GameState %zu)\n",
+               len, (unsigned)SNAPSHOT_MAX, sizeof(GameState));
+        printf("Save: %.2f us  Load: %.2f us (host, per snapshot)\n",
+               (double)(t1 - t0) * 1e6 / CLOCKS_PER_SEC / reps,
+               (double)(t2 - t1) * 1e6 / CLOCKS_PER_SEC / reps);
+        if (restored && replayed && rejected) {
+            printf("Restore and replay match (Success)\n");
+        } else {
+            printf("Save state mismatch: restored=%d replayed=%d rejected=%d (Error)\n",
+                   restored, replayed, rejected);
+            failures++;
+        }
+    }
+#endif
+    
+    // Test 8: NVM persistence - batched writes survive a remount
+    {
+        const char* image = "build/nvm_test.bin";
+        uint8_t record[100], check[100];
+        // Start from an erased image: pages left over from an earlier run
+        // would match and be skipped, hiding how many programs it takes
+        remove(image);
+        bool mounted = nvm_init(image);
+        if (!mounted) {
+            image = NULL;
+            mounted = nvm_init(NULL);
+        }
+        
+        // A record straddling a page boundary, rewritten in small pieces
+        for (int i = 0; i < (int)sizeof(record); i++) record[i] = (uint8_t)(i * 7 + 3);
+        for (int i = 0; i < (int)sizeof(record); i += 10) {
+            nvm_write(NVM_PAGE_SIZE - 20 + i, &record[i], 10);
+        }
+        NvmStats batched = *nvm_get_stats();
+        nvm_flush();
+        uint32_t programs = nvm_get_stats()->page_programs;
+        // One program per page the record touches, however many writes
+        uint32_t spanned = (NVM_PAGE_SIZE - 20 + sizeof(record) - 1) / NVM_PAGE_SIZE
+                         - (NVM_PAGE_SIZE - 20) / NVM_PAGE_SIZE + 1;
+        bool batched_ok = batched.page_programs == 0 && programs == spanned;
+        
+        if (image) {
+            nvm_close();
+            nvm_init(image);
+        }
+        bool read_ok = nvm_read(NVM_PAGE_SIZE - 20, check, sizeof(check));
+        bool persisted = mounted && read_ok && memcmp(record, check, sizeof(record)) == 0;
+        bool bounded = !nvm_read(NVM_SIZE - 10, check, 20) &&
+                       !nvm_write(NVM_SIZE - 10, record, 20);
+        
+        printf("\n=== NVM Persistence (%s) ===\n", image ? image : "in-memory");
+        printf("10 writes, %u bytes -> %u page programs after flush (%u before, %u expected)\n",
+               (unsigned)batched.bytes_requested, (unsigned)programs,
+               (unsigned)batched.page_programs, (unsigned)spanned);
+        if (!batched_ok) {
+            printf("Writes were not batched into page programs (Error)\n");
+            failures++;
+        }
+        if (!bounded) {
+            printf("NVM access past the end of the image was allowed (Error)\n");
+            failures++;
+        }
+               
+#if HAS_SAVE_STATES
+        // Autosave every 50 ticks and measure the NVM cost
+        {
+            uint8_t snap[SNAPSHOT_MAX];
+            uint8_t tick[4] = {CLA_DOOM, INS_UPDATE_GAME, 0x00, 0x00};
+            uint16_t len = 0;
+            const int saves = 20;
+            
+            nvm_reset_stats();
+            for (int n = 0; n < saves; n++) {
+                for (int t = 0; t < 50; t++) process_apdu(tick, 4, resp, &resp_len);
+                len = apdu_save_snapshot(snap, sizeof(snap));
+                nvm_write(0, &len, sizeof(len));
+                nvm_write(sizeof(len), snap, len);
+                nvm_flush();
+            }
+            
+            const NvmStats* st = nvm_get_stats();
+            nvm_read(sizeof(len), check, len < sizeof(check) ? len : sizeof(check));
+            persisted = persisted && memcmp(snap, check, len < sizeof(check) ? len : sizeof(check)) == 0;
+            printf("Autosave x%d: %u bytes requested, %u programmed (%u pages, %u skipped)\n",
+                   saves, (unsigned)st->bytes_requested, (unsigned)st->bytes_programmed,
+                   (unsigned)st->page_programs, (unsigned)st->programs_skipped);
+            printf("Modelled NVM time: %.1f ms per autosave, max page wear %u\n",
+                   st->program_us / 1000.0 / saves, st->max_page_wear);
+        }
+#endif
+        nvm_close();
+        if (nvm_read(0, check, 1)) {
+            printf("NVM read with no image attached (Error)\n");
+            failures++;
+        }
+        
+        if (persisted) {
+            printf("NVM contents verified (Success)\n");
+        } else {
+            printf("NVM contents differ (Error)\n");
+            failures++;
+        }
+    }
+    
+    // Test 9: Generated levels - every seed and level must be completable
+    {
+        static GameState lv;
+        static uint8_t seen[MAP_H][MAP_W];
+        static uint16_t queue[MAP_W * MAP_H];
+        int levels = 0, broken = 0;
+        // Streamed levels are bigger and are baked into NVM as they load;
+        // compiled levels are the same for every seed
+        const uint32_t seeds = MAP_STREAMED ? 10 : LEVEL_COMPILED ? 1 : 200;
+        const int last_level = LEVEL_COMPILED ? LEVEL_COUNT : 10;
+        
+        for (uint32_t seed = 1; seed <= seeds; seed++) {
+            for (uint8_t level = 1; level <= last_level; level++) {
+                memset(&lv, 0, sizeof(lv));
+                lv.seed = seed;
+                init_level(&lv, level);
+                
+                // Flood fill from the spawn; closed doors open on contact
+                memset(seen, 0, sizeof(seen));
+                int head = 0, tail = 0;
+                int sx = COORD_TILE(lv.player_x), sy = COORD_TILE(lv.player_y);
+                seen[sy][sx] = 1;
+                queue[tail++] = (uint16_t)(sy * MAP_W + sx);
+                while (head < tail) {
+                    int x = queue[head] % MAP_W, y = queue[head] / MAP_W;
+                    head++;
+                    const int step[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+                    for (int d = 0; d < 4; d++) {
+                        int nx = x + step[d][0], ny = y + step[d][1];
+                        if (seen[ny][nx] || level_tile(&lv, nx, ny) == TILE_WALL) continue;
+                        seen[ny][nx] = 1;
+                        queue[tail++] = (uint16_t)(ny * MAP_W + nx);
+                    }
+                }
+                
+                bool ok = seen[LEVEL_EXIT_Y(&lv.layout)][LEVEL_EXIT_X(&lv.layout)];
+                for (int i = 0; i < LEVEL_PICKUP_COUNT(&lv.layout); i++) {
+                    ok = ok && seen[lv.layout.pickups[i].y][lv.layout.pickups[i].x];
+                }
+                levels++;
+                if (!ok) broken++;
+            }
+        }
+        
+        printf("\n=== %s Levels ===\n", LEVEL_COMPILED ? "Compiled" : "Generated");
+        printf("%d levels, %d with an unreachable exit or pickup\n", levels, broken);
+        printf("Level descriptor: %u bytes (a stored map would be %u)\n",
+               (unsigned)(sizeof(LevelDesc) + sizeof(PickupMask) + sizeof(DoorMask)),
+               (unsigned)(MAP_W * MAP_H));
+        if (broken) {
+            printf("Level generator produced broken levels (Error)\n");
+            failures++;
+        } else {
+            printf("All levels completable (Success)\n");
+        }
+    }
+    
+    // Test 10: Map lookups and counters - the tile the game sees must match
+    // the generator wherever it comes from
+    {
+        uint8_t init[4] = {CLA_DOOM, INS_INIT_GAME, 0x12, 0x34};
+        uint8_t frame[4] = {CLA_DOOM, INS_UPDATE_GAME, 0x00, 0x00};
+        uint8_t screen[4] = {CLA_DOOM, INS_GET_SCREEN, 0x00, 0x00};
+        uint8_t stats[4] = {CLA_DOOM, INS_GET_STATS, 0x00, 0x01};
+        int mismatches = 0;
+        
+        process_apdu(init, 4, resp, &resp_len);
+        process_apdu(stats, 4, resp, &resp_len);   // Read and reset
+        for (int t = 0; t < 100; t++) {
+            process_apdu(frame, 4, resp, &resp_len);
+            process_apdu(screen, 4, resp, &resp_len);
+        }
+        printf("\n=== Map Lookups (%dx%d, %s) ===\n", MAP_W, MAP_H,
+               MAP_STREAMED ? "streamed from NVM" : "derived per tile");
+        stats[3] = 0x00;
+        process_apdu(stats, 4, resp, &resp_len);
+#if MAP_STREAMED
+        if (resp_len == 18 && resp[16] == 0x90) {
+            uint32_t lookups = ((uint32_t)resp[0] << 24) | ((uint32_t)resp[1] << 16) | (resp[2] << 8) | resp[3];
+            uint32_t hits = ((uint32_t)resp[4] << 24) | ((uint32_t)resp[5] << 16) | (resp[6] << 8) | resp[7];
+            uint32_t misses = ((uint32_t)resp[8] << 24) | ((uint32_t)resp[9] << 16) | (resp[10] << 8) | resp[11];
+            uint32_t prefetched = ((uint32_t)resp[12] << 24) | ((uint32_t)resp[13] << 16) | (resp[14] << 8) | resp[15];
+            printf("100 frames: %u lookups, %.2f%% hits, %u misses, %u chunks prefetched\n",
+                   (unsigned)lookups, lookups ? 100.0 * hits / lookups : 0.0,
+                   (unsigned)misses, (unsigned)prefetched);
+        } else {
+            mismatches++;
+        }
+#else
+        if (resp[resp_len - 2] != 0x69 || resp[resp_len - 1] != 0x85) mismatches++;
+#endif
+        stats[2] = 0x01;
+        process_apdu(stats, 4, resp, &resp_len);
+        if (resp_len != 22 || resp[20] != 0x90) mismatches++;
+        
+        for (int y = 0; y < MAP_H; y++) {
+            for (int x = 0; x < MAP_W; x++) {
+                if (map_tile(&game, x, y) != level_tile(&game, x, y)) mismatches++;
+            }
+        }
+        
+        if (mismatches) {
+            printf("%d map lookup or counter mismatches (Error)\n", mismatches);
+            failures++;
+        } else {
+            printf("Every tile matches the generator (Success)\n");
+        }
+    }
+    
+    // Test 11: Level progression - the exit loads the next level over
+    // several ticks, during which the card reports "loading"
+    {
+        uint8_t init[4] = {CLA_DOOM, INS_INIT_GAME, 0x00, 0x07};
+        uint8_t walk[6] = {CLA_DOOM, INS_PROCESS_INPUT, 0x00, 0x00, 0x01, 'w'};
+        uint8_t tick[4] = {CLA_DOOM, INS_UPDATE_GAME, 0x00, 0x00};
+        uint8_t status[5] = {CLA_DOOM, INS_GET_STATUS, 0x00, 0x00, 0x00};
+        bool ok = true;
+        int ticks = 0;
+        
+        process_apdu(init, 4, resp, &resp_len);
+        
+        // Stand just west of the exit, facing it, and walk in
+        game.player_x = TILE_COORD(LEVEL_EXIT_X(&game.layout) - 1);
+        game.player_y = TILE_COORD(LEVEL_EXIT_Y(&game.layout));
+        game.player_angle = DIR_EAST;
+        game.enemies.live = 0;
+        process_apdu(walk, 6, resp, &resp_len);
+        process_apdu(walk, 6, resp, &resp_len);
+        
+        process_apdu(status, 5, resp, &resp_len);
+        printf("\n=== Level Progression (%d levels) ===\n", LEVEL_COUNT);
+        if (LEVEL_COUNT == 1) {
+            ok = resp_len == 11 && resp[4] == 1 && resp[5] == 0;
+            printf("Single-level profile: exit is %s\n", ok ? "victory" : "not victory");
+        } else {
+            ok = resp_len == 11 && resp[2] == 2 && resp[5] == 1;
+            
+#if HAS_SAVE_STATES
+            // No snapshot of a half-built level
+            uint8_t save[5] = {CLA_DOOM, INS_SAVE_STATE, 0x00, 0x00, 0x00};
+            process_apdu(save, 5, resp, &resp_len);
+            ok = ok && resp_len == 2 && resp[0] == 0x69 && resp[1] == 0x85;
+#endif
+            
+            do {
+                process_apdu(tick, 4, resp, &resp_len);
+                process_apdu(status, 5, resp, &resp_len);
+                ticks++;
+            } while (resp[5] && ticks < 1000);
+            ok = ok && resp[5] == 0 && resp[6] == 100 && resp[2] == 2 && resp[3] == 0;
+            printf("Level 2 built over %d UPDATE_GAME commands\n", ticks);
+        }
+        
+#if MAP_STREAMED
+        // Every build step must stay within one command's NVM budget
+        {
+            uint32_t worst_us = 0;
+            int steps = 0;
+            game.seed++;                // A new layout, so every chunk is reprogrammed
+            begin_level(&game, game.level);
+            do {
+                nvm_reset_stats();
+                steps++;
+                level_build_step(&game);
+                if (nvm_get_stats()->program_us > worst_us) worst_us = nvm_get_stats()->program_us;
+            } while (LEVEL_LOADING(&game));
+            printf("Streamed level rebuilt in %d steps, worst step %.1f ms of NVM programming\n",
+                   steps, worst_us / 1000.0);
+            ok = ok && steps == 2 + MAP_CHUNK_COUNT / LEVEL_BAKE_CHUNKS &&
+                 worst_us <= LEVEL_BAKE_CHUNKS / 2 * NVM_PROGRAM_US;
+        }
+#endif
+        
+        if (ok) {
+            printf("Progression works (Success)\n");
+        } else {
+            printf("Progression broken (Error)\n");
+            failures++;
+        }
+    }
+    
+    // Test 12: Memory arenas - LOAD_STATE stages its upload in the
+    // persistent arena and checks it in transient scratch, which is handed
+    // back before the next command; GET_SCREEN needs none. Profiles
+    // without save states have neither arena.
+    {
+        uint8_t screen[4] = {CLA_DOOM, INS_GET_SCREEN, 0x00, 0x00};
+        uint8_t stats[4] = {CLA_DOOM, INS_GET_STATS, 0x02, 0x01};
+        bool ok;
+        
+        process_apdu(stats, 4, resp, &resp_len);   // Restart high-water marks
+        process_apdu(screen, 4, resp, &resp_len);
+#if HAS_SAVE_STATES
+        static uint8_t snap[SNAPSHOT_MAX];
+        uint32_t before = apdu_state_hash();
+        uint16_t len = apdu_save_snapshot(snap, sizeof(snap));
+        bool loaded = len && apdu_load_snapshot(snap, len, 255) && apdu_state_hash() == before;
+#endif
+        stats[3] = 0x00;
+        process_apdu(stats, 4, resp, &resp_len);
+        
+        printf("\n=== Memory Arenas ===\n");
+        ok = resp_len == 20 && resp[18] == 0x90;
+        for (int i = 0; ok && i < ARENA_COUNT; i++) {
+            const char* names[ARENA_COUNT] = {"persistent", "level", "transient"};
+            uint16_t size = (uint16_t)((resp[i * 6] << 8) | resp[i * 6 + 1]);
+            uint16_t used = (uint16_t)((resp[i * 6 + 2] << 8) | resp[i * 6 + 3]);
+            uint16_t high = (uint16_t)((resp[i * 6 + 4] << 8) | resp[i * 6 + 5]);
+            printf("%-10s %5u bytes, %5u in use, high water %5u\n", names[i], size, used, high);
+#if HAS_SAVE_STATES
+            if (i == ARENA_PERSISTENT) ok = loaded && used >= SNAPSHOT_MAX;
+            if (i == ARENA_TRANSIENT) ok = used == 0 && high >= sizeof(GameState);
+#else
+            if (i != ARENA_LEVEL) ok = size == 0 && high == 0;
+#endif
+        }
+        
+        // Mark/rewind hands back exactly what was taken after the mark
+        SimArena scratch = ARENA_TRANSIENT_SIZE ? ARENA_TRANSIENT : ARENA_LEVEL;
+        ArenaMark mark = sim_arena_mark(scratch);
+        uint8_t* a = sim_arena_alloc(scratch, 3);
+        uint8_t* b = sim_arena_alloc(scratch, sim_arena_get_stats(scratch)->size);
+        sim_arena_rewind(scratch, mark);
+        ok = ok && a && !b && sim_arena_alloc(scratch, 4) == a;
+        sim_arena_rewind(scratch, mark);
+        
+        if (ok) {
+            printf("Arenas released on schedule (Success)\n");
+        } else {
+            printf("Arena accounting wrong (Error)\n");
+            failures++;
+        }
+    }
+    
+    // Test 13: Screen in row chunks - GET_SCREEN plus chained GET RESPONSE
+    // must deliver the same frame as a single full GET_SCREEN. A card
+    // answers in short APDUs whatever it is asked for.
+    {
+        static uint8_t full[SCREEN_W * SCREEN_H];
+        static uint8_t chunked[SCREEN_W * SCREEN_H];
+        static uint8_t cells[SCREEN_W * SCREEN_H];
+        Frame host = {cells, SCREEN_W, SCREEN_W, SCREEN_H};
+        uint8_t more[5] = {0x00, INS_GET_RESPONSE, 0x00, 0x00, 0x00};
+        const uint8_t rows = 6;
+        bool ok;
+        
+        ok = apdu_get_screen(0, full, sizeof(full), &responses, &largest) == sizeof(full);
+#ifdef SIM_CARD_TARGET
+        ok = ok && largest <= CARD_RESP_DATA;
+#else
+        ok = ok && responses == 1;
+#endif
+        ok = ok && apdu_get_screen(rows, chunked, sizeof(chunked), &responses, &largest) == sizeof(chunked) &&
+             largest <= rows * SCREEN_W && memcmp(full, chunked, sizeof(full)) == 0;
+        
+        // Nothing left to continue once the frame is complete
+        process_apdu(more, 5, resp, &resp_len);
+        ok = ok && resp_len == 2 && resp[0] == 0x69 && resp[1] == 0x85;
+        
+        render_frame(&game, &host);
+        ok = ok && memcmp(full, cells, sizeof(full)) == 0;
+        
+        printf("\n=== Screen Rows ===\n");
+        printf("Frame fetched in %d responses of up to %d rows\n", responses, rows);
+        if (ok) {
+            printf("Chunked frame matches the full frame (Success)\n");
+        } else {
+            printf("Chunked frame differs (Error)\n");
+            failures++;
+        }
+    }
+    
+    // Test 14: Pool capacities - fixed profiles report their compile-time
+    // pools; the adaptive profile sizes them to the card at INIT, and
+    // refuses a card below the minimal pools. Every
+    // profile gives the level arena what the card has beyond RAM_FIXED.
+    {
+        const uint32_t cards[] = {3072, 4096, 4608, 8192, 65536};
+        uint8_t init[4] = {CLA_DOOM, INS_INIT_GAME, 0x00, 0x09};
+        uint8_t fire[6] = {CLA_DOOM, INS_PROCESS_INPUT, 0x00, 0x00, 0x01, ' '};
+        uint8_t tick[4] = {CLA_DOOM, INS_UPDATE_GAME, 0x00, 0x00};
+        uint8_t status[5] = {CLA_DOOM, INS_GET_STATUS, 0x00, 0x00, 0x00};
+#if ADAPTIVE_CAPACITY
+        uint8_t last_enemies = 0;
+#endif
+        bool ok = true;
+        
+        printf("\n=== Pool Capacities (%s) ===\n", MEMORY_SIZE_STR);
+        printf("Applet fixed RAM %u bytes, level arena up to %u\n",
+               (unsigned)RAM_FIXED, (unsigned)ARENA_LEVEL_SIZE);
+        for (int c = 0; c < (int)(sizeof(cards) / sizeof(cards[0])); c++) {
+            uint32_t left = cards[c] > RAM_FIXED ? cards[c] - RAM_FIXED : 0;
+            sim_set_card_ram(cards[c]);
+            process_apdu(init, 4, resp, &resp_len);
+#if ADAPTIVE_CAPACITY
+            // A card without room for the minimal pools is refused, and
+            // commands after it find no game
+            if (left < LEVEL_ARENA_MIN) {
+                bool refused = resp_len == 2 && resp[0] == 0x69 && resp[1] == 0x85;
+                process_apdu(tick, 4, resp, &resp_len);
+                refused = refused && resp_len == 2 && resp[0] == 0x69 && resp[1] == 0x86;
+                printf("%5u byte card: INIT_GAME refused%s\n", (unsigned)cards[c],
+                       refused ? "" : " - NOT");
+                ok = ok && refused;
+                continue;
+            }
+            ok = ok && resp_len == 2 && resp[0] == 0x90;
+#endif
+            for (int t = 0; t < 5000 && LEVEL_LOADING(&game); t++) {
+                process_apdu(tick, 4, resp, &resp_len);
+            }
+            for (int t = 0; t < 50; t++) {
+                process_apdu(fire, 6, resp, &resp_len);
+                process_apdu(tick, 4, resp, &resp_len);
+            }
+            process_apdu(status, 5, resp, &resp_len);
+            if (resp_len != 11) { ok = false; break; }
+            
+            printf("%5u byte card: %2u enemies, %2u bullets, level arena %u bytes\n",
+                   (unsigned)cards[c], resp[7], resp[8],
+                   sim_arena_get_stats(ARENA_LEVEL)->size);
+            ok = ok && sim_arena_get_stats(ARENA_LEVEL)->size ==
+                       (left < ARENA_LEVEL_SIZE ? left : ARENA_LEVEL_SIZE);
+#if ADAPTIVE_CAPACITY
+            // More RAM never buys fewer slots, and the pools reach their
+            // ceilings exactly when the card has what they need
+            ok = ok && resp[7] >= last_enemies && resp[7] >= MIN_ENEMIES && resp[8] >= MIN_BULLETS;
+            if (left >= LEVEL_ARENA_NEED) {
+                ok = ok && resp[7] == MAX_ENEMIES && resp[8] == MAX_BULLETS;
+            } else {
+                ok = ok && resp[7] < MAX_ENEMIES;
+            }
+            last_enemies = resp[7];
+#else
+            ok = ok && resp[7] == MAX_ENEMIES && resp[8] == MAX_BULLETS;
+#endif
+        }
+        sim_set_card_ram(SIM_CARD_RAM);
+        
+        if (ok) {
+            printf("Capacities follow the card (Success)\n");
+        } else {
+            printf("Capacity reporting wrong (Error)\n");
+            failures++;
+        }
+    }
+    
+    // Test 15: Enemy wake-ups - every alerted enemy is booked on the timing
+    // wheel exactly once, no further ahead than its level of detail allows
+    {
+        uint8_t init[4] = {CLA_DOOM, INS_INIT_GAME, 0x00, 0x0B};
+        uint8_t fire[6] = {CLA_DOOM, INS_PROCESS_INPUT, 0x00, 0x00, 0x01, ' '};
+        uint8_t tick[4] = {CLA_DOOM, INS_UPDATE_GAME, 0x00, 0x00};
+        int ticks = 0, turns = 0;
+        bool ok = true;
+        
+        printf("\n=== Enemy Wake-ups ===\n");
+        process_apdu(init, 4, resp, &resp_len);
+        process_apdu(fire, 6, resp, &resp_len);     // Wake the neighbourhood
+        for (int t = 0; ok && t < 40 && !game.game_over; t++) {
+            EnemyMask booked = 0;
+            int i;
+            
+            for (int w = 1; w <= ENEMY_WHEEL_SLOTS; w++) {
+                EnemyMask slot = game.enemies.wake[ENEMY_WHEEL_SLOT(game.frame_count + w)] & game.enemies.live;
+                ok = ok && !(booked & slot);
+                booked |= slot;
+            }
+            ok = ok && booked == (EnemyMask)(game.enemies.live & ~game.enemies.idle);
+            FOR_EACH_LIVE(EnemyMask, booked, i) {
+                EnemyMask bit = SLOT_BIT(EnemyMask, i);
+                int limit = (game.enemies.dormant & bit) ? AI_DORMANT_WAIT :
+                            (game.enemies.coarse & bit) ? AI_COARSE_WAIT : ENEMY_SPEED;
+                ok = ok && enemy_wait(&game, i) >= 1 && enemy_wait(&game, i) <= limit;
+            }
+            EnemyMask due = game.enemies.wake[ENEMY_WHEEL_SLOT(game.frame_count + 1)] & game.enemies.live;
+            FOR_EACH_LIVE(EnemyMask, due, i) turns++;
+            process_apdu(tick, 4, resp, &resp_len);
+            ticks++;
+        }
+        printf("Ticks: %d, enemy turns: %d\n", ticks, turns);
+        
+        if (ok) {
+            printf("Each enemy is booked once (Success)\n");
+        } else {
+            printf("Timing wheel out of step (Error)\n");
+            failures++;
+        }
+    }
+    
+    // Test 16: AI level of detail - with the player in a corner room, far
+    // enemies drop to coarse turns or go dormant, and dormant ones stay put
+    // until the player comes back, then catch up in one move
+    {
+        int near = 0, coarse = 0, dormant = 0, i;
+        int px = 0, py = 0, ex = 0, ey = 0;
+        bool ok = true;
+        
+        printf("\n=== AI Level of Detail ===\n");
+        init_game_seeded(&game, 0x0B);
+        FOR_EACH_LIVE(EnemyMask, game.enemies.idle, i) enemy_alert(&game, i);
+        floor_span(0, &px, &py, &ex, &ey);
+        game.player_x = TILE_COORD(px);
+        game.player_y = TILE_COORD(py);
+        for (int t = 0; ok && t < 4 * ENEMY_WHEEL_SLOTS; t++) {
+            EnemyMask was_dormant = game.enemies.dormant & game.enemies.live;
+            coord_t x[MAX_ENEMIES], y[MAX_ENEMIES];
+            
+            FOR_EACH_LIVE(EnemyMask, was_dormant, i) {
+                x[i] = game.enemies.x[i];
+                y[i] = game.enemies.y[i];
+            }
+            update_game(&game);
+            FOR_EACH_LIVE(EnemyMask, was_dormant & game.enemies.dormant, i) {
+                ok = ok && game.enemies.x[i] == x[i] && game.enemies.y[i] == y[i];
+            }
+        }
+        FOR_EACH_LIVE(EnemyMask, game.enemies.live, i) {
+            EnemyMask bit = SLOT_BIT(EnemyMask, i);
+            if (game.enemies.dormant & bit) dormant++;
+            else if (game.enemies.coarse & bit) coarse++;
+            else near++;
+        }
+        printf("Map %dx%d: near box %dx%d, wake box %dx%d tiles\n", MAP_W, MAP_H,
+               2 * AI_NEAR_X, 2 * AI_NEAR_Y, 2 * AI_WAKE_X, 2 * AI_WAKE_Y);
+        printf("Enemies: %d near, %d coarse, %d dormant\n", near, coarse, dormant);
+        
+        // Look for a level whose floor spans more than the wake box, and
+        // park the player and enemy 0 at its two ends. Rooms keep a tile
+        // of margin inside their cells, so floor spans at most the cells
+        // less three tiles; a map whose floor cannot outspan the wake box
+        // keeps every enemy awake.
+        bool tiers = AI_WAKE_X < LEVEL_CELLS_X * LEVEL_CELL - 3 ||
+                     AI_WAKE_Y < LEVEL_CELLS_Y * LEVEL_CELL - 3;
+        bool found = false;
+        int span = 0;
+        for (uint32_t seed = 0x0B; tiers && !found && seed < 0x0B + 64; seed++) {
+            init_game_seeded(&game, seed);
+            for (int axis = 0; axis < 2 && !found; axis++) {
+                span = floor_span(axis, &px, &py, &ex, &ey);
+                found = span > (axis ? AI_WAKE_Y : AI_WAKE_X);
+            }
+        }
+        
+        int slept = -1, caught = -1, woke = -1;
+        bool far_ok = found, catch_ok = found, near_ok = found;
+        if (found) {
+            game.enemies.live = SLOT_BIT(EnemyMask, 0);
+            game.enemies.x[0] = TILE_COORD(ex) + FP_HALF;    // Its first step stays on
+            game.enemies.y[0] = TILE_COORD(ey) + FP_HALF;    // the far tile
+            enemy_alert(&game, 0);
+            game.player_x = TILE_COORD(px) + FP_HALF;
+            game.player_y = TILE_COORD(py) + FP_HALF;
+            for (int t = 0; t < ENEMY_WHEEL_SLOTS && slept < 0; t++) {
+                update_game(&game);
+                if (game.enemies.dormant & SLOT_BIT(EnemyMask, 0)) slept = t;
+            }
+            coord_t x0 = game.enemies.x[0], y0 = game.enemies.y[0];
+            far_ok = slept >= 0;
+            for (int t = 0; far_ok && t < 4 * ENEMY_WHEEL_SLOTS; t++) {
+                update_game(&game);
+                far_ok = (game.enemies.dormant & SLOT_BIT(EnemyMask, 0)) &&
+                         game.enemies.x[0] == x0 && game.enemies.y[0] == y0;
+            }
+            
+            // Come back to a floor tile just inside the wake box: the next
+            // distance check moves the enemy the last wait's turns at once,
+            // straight at the player where the line is open, and never
+            // into a wall
+            int qx = -1, qy = -1;
+            for (int y = 1; qx < 0 && y < MAP_H - 1; y++) {
+                for (int x = 1; x < MAP_W - 1; x++) {
+                    int dx = x > ex ? x - ex : ex - x, dy = y > ey ? y - ey : ey - y;
+                    if (map_tile(&game, x, y) == TILE_EMPTY &&
+                        dx <= AI_WAKE_X && dy <= AI_WAKE_Y && (dx > AI_NEAR_X || dy > AI_NEAR_Y)) {
+                        qx = x;
+                        qy = y;
+                        break;
+                    }
+                }
+            }
+            catch_ok = far_ok && qx >= 0;
+            if (catch_ok) {
+                game.player_x = TILE_COORD(qx) + FP_HALF;
+                game.player_y = TILE_COORD(qy) + FP_HALF;
+            }
+            for (int t = 0; catch_ok && t < AI_DORMANT_WAIT && caught < 0; t++) {
+                update_game(&game);
+                if (!(game.enemies.dormant & SLOT_BIT(EnemyMask, 0))) caught = t;
+            }
+            if (caught >= 0) {
+                int32_t reach = AI_DORMANT_TURNS * FP_HALF;
+                int32_t mx = (int32_t)game.player_x - x0, my = (int32_t)game.player_y - y0;
+                int32_t gx = (int32_t)game.enemies.x[0] - x0, gy = (int32_t)game.enemies.y[0] - y0;
+                int hit;
+                
+                if (mx > reach) mx = reach;
+                if (mx < -reach) mx = -reach;
+                if (my > reach) my = reach;
+                if (my < -reach) my = -reach;
+                int tiles = move_tiles(x0, y0, mx, my);
+                bool open = walk_tiles(&game, x0, y0, (coord_delta_t)mx, (coord_delta_t)my, tiles, 0, &hit) == tiles;
+                
+                // Each axis moves towards the player, no further than the
+                // turns reach, and all the way when nothing is in the way
+                catch_ok = !check_collision(&game, game.enemies.x[0], game.enemies.y[0]) &&
+                           gx * mx >= 0 && gx * gx <= mx * mx && gy * my >= 0 && gy * gy <= my * my &&
+                           (!open || (gx == mx && gy == my));
+                printf("Back inside the wake box: the enemy moved %d,%d half tiles in one go (line %s)\n",
+                       (int)(gx / FP_HALF), (int)(gy / FP_HALF), open ? "open" : "blocked");
+            } else {
+                catch_ok = false;
+            }
+            
+            // Walk up to it: the next distance check books it at full detail
+            int ax = COORD_TILE(game.enemies.x[0]), ay = COORD_TILE(game.enemies.y[0]);
+            int nx = -1, ny = -1;
+            for (int y = ay - 2; nx < 0 && y <= ay + 2; y++) {
+                for (int x = ax - 2; x <= ax + 2; x++) {
+                    if ((x != ax || y != ay) && x > 0 && x < MAP_W - 1 && y > 0 && y < MAP_H - 1 &&
+                        map_tile(&game, x, y) == TILE_EMPTY) {
+                        nx = x;
+                        ny = y;
+                        break;
+                    }
+                }
+            }
+            near_ok = nx >= 0;
+            if (near_ok) {
+                game.player_x = TILE_COORD(nx) + FP_HALF;
+                game.player_y = TILE_COORD(ny) + FP_HALF;
+            }
+            for (int t = 0; near_ok && t < AI_COARSE_WAIT && woke < 0; t++) {
+                update_game(&game);
+                if (!(game.enemies.coarse & SLOT_BIT(EnemyMask, 0))) woke = t;
+            }
+            near_ok = woke >= 0 && !(game.enemies.dormant & SLOT_BIT(EnemyMask, 0)) &&
+                      enemy_wait(&game, 0) == ENEMY_SPEED;
+            printf("Floor %d tiles across: dormant after %d ticks, full detail %d ticks after the player came near\n",
+                   span, slept + 1, woke + 1);
+        } else {
+            printf("No level's floor spans the wake box: every enemy stays awake\n");
+        }
+        
+        if (ok && (far_ok || !tiers)) {
+            printf("Dormant enemies stay put (Success)\n");
+        } else {
+            printf("A dormant enemy moved or never went dormant (Error)\n");
+            failures++;
+        }
+        if (catch_ok || !tiers) {
+            printf("Woken enemy caught up in one move (Success)\n");
+        } else {
+            printf("Woken enemy did not catch up (Error)\n");
+            failures++;
+        }
+        if (near_ok || !tiers) {
+            printf("Dormant enemy woke when the player approached (Success)\n");
+        } else {
+            printf("Dormant enemy did not wake (Error)\n");
+            failures++;
+        }
+    }
+    
+    // Test 17: Hitscan - the rifle hits the first enemy in line the moment
+    // it fires, without taking a bullet slot
+    {
+        uint8_t init[4] = {CLA_DOOM, INS_INIT_GAME, 0x00, 0x11};
+        uint8_t weapon[6] = {CLA_DOOM, INS_PROCESS_INPUT, 0x00, 0x00, 0x01, 'f'};
+        uint8_t fire[6] = {CLA_DOOM, INS_PROCESS_INPUT, 0x00, 0x00, 0x01, ' '};
+        bool ok = true;
+        
+        printf("\n=== Hitscan ===\n");
+        process_apdu(init, 4, resp, &resp_len);
+        process_apdu(weapon, 6, resp, &resp_len);
+        
+        // Line enemy 0 up at the east wall of the start room (the player
+        // starts in its centre, facing east)
+#if LEVEL_COMPILED
+        int east = COORD_TILE(game.player_x);
+        while (map_tile(&game, east + 1, COORD_TILE(game.player_y)) == TILE_EMPTY) east++;
+#else
+        const LevelRoom* room = &game.layout.rooms[0];
+        int east = room->x + room->w - 1;
+#endif
+        game.enemies.x[0] = TILE_COORD(east);
+        game.enemies.y[0] = game.player_y;
+        uint8_t ammo = game.ammo;
+        
+        ok = ok && game.weapon == WEAPON_RIFLE && game.player_angle == DIR_EAST;
+        ok = ok && trace_shot(&game, game.player_x, game.player_y, 0, -FP_SCALE, MAP_H) < 0;
+        process_apdu(fire, 6, resp, &resp_len);
+        ok = ok && game.enemies.health[0] == 1 && game.bullets.live == 0 && game.ammo == ammo - 1;
+        process_apdu(fire, 6, resp, &resp_len);
+        ok = ok && !(game.enemies.live & SLOT_BIT(EnemyMask, 0));
+        printf("Enemy %d tiles east: %s after two shots, %d bullets in flight\n",
+               east - COORD_TILE(game.player_x),
+               (game.enemies.live & 1) ? "alive" : "dead", game.bullets.live ? 1 : 0);
+        
+        if (ok) {
+            printf("Shots resolved on the spot (Success)\n");
+        } else {
+            printf("Hitscan missed (Error)\n");
+            failures++;
+        }
+    }
+    
+    // Test 18: Alerting - idle enemies stay off the wheel and put until a
+    // noise reaches their room or the player's room sees it; the cached
+    // sight lines agree with tracing them afresh
+    {
+        int idle_before = 0, woken = 0, stray = 0, i;
+        bool ok = true;
+        
+        printf("\n=== Noise and Sight ===\n");
+        init_game_seeded(&game, 0x42);
+        EnemyMask idle = game.enemies.idle & game.enemies.live;
+        FOR_EACH_LIVE(EnemyMask, idle, i) idle_before++;
+        
+        // Nothing happens: idle enemies are never due and never move
+        coord_t x0 = game.enemies.x[0], y0 = game.enemies.y[0];
+        for (int t = 0; t < 2 * ENEMY_WHEEL_SLOTS; t++) update_game(&game);
+        for (int w = 0; w < ENEMY_WHEEL_SLOTS; w++) ok = ok && !(game.enemies.wake[w] & idle);
+        if (idle & 1) ok = ok && game.enemies.x[0] == x0 && game.enemies.y[0] == y0;
+        
+        // A shot wakes exactly the idle enemies in the rooms it carries to
+        RoomMask heard = noise_spread(&game, rooms_at(&game, COORD_TILE(game.player_x),
+                                                      COORD_TILE(game.player_y)), NOISE_SHOT_HOPS);
+        fire_bullet(&game);
+        FOR_EACH_LIVE(EnemyMask, idle, i) {
+            int r = room_at(&game, COORD_TILE(game.enemies.x[i]), COORD_TILE(game.enemies.y[i]));
+            bool in_reach = r >= 0 && (heard & SLOT_BIT(RoomMask, r));
+            bool awake = !(game.enemies.idle & SLOT_BIT(EnemyMask, i));
+            if (awake) woken++;
+            if (awake != in_reach) stray++;
+        }
+        ok = ok && stray == 0;
+        
+        // Cached sight lines (traced on first use) match fresh traces
+        for (int a = 0; a < game.layout.room_count; a++) {
+            for (int b = 0; b < game.layout.room_count; b++) {
+                bool cached = rooms_see(&game, a, b);
+                ok = ok && cached == (a == b || rooms_trace(&game, a < b ? a : b, a < b ? b : a));
+                ok = ok && cached == rooms_see(&game, b, a);
+            }
+        }
+        int rooms_heard = 0;
+        FOR_EACH_LIVE(RoomMask, heard, i) rooms_heard++;
+        printf("Idle at start: %d, woken by a shot: %d, rooms heard: %d of %d\n",
+               idle_before, woken, rooms_heard, game.layout.room_count);
+        
+#if HAS_SAVE_STATES
+        // A save made with the doors open loads without the sight lines
+        // cached while the level was rebuilt with every door shut
+        int opened = 0;
+        for (uint16_t seed = 1; seed <= 50; seed++) {
+            static uint8_t snap[SNAPSHOT_MAX];
+            
+            init_game_seeded(&game, seed);
+            game.doors_open = SLOTS_ALL(DoorMask, LEVEL_DOOR_COUNT(&game.layout));
+            reset_room_sight();
+            uint16_t len = save_state_read(&game, 0, snap, sizeof(snap));
+            ok = ok && len && save_state_apply(&game, snap, len);
+            sim_arena_reset(ARENA_TRANSIENT);   // As the end of an APDU does
+            for (int a = 0; a < game.layout.room_count; a++) {
+                for (int b = a + 1; b < game.layout.room_count; b++) {
+                    bool open = rooms_trace(&game, a, b);
+                    ok = ok && rooms_see(&game, a, b) == open;
+                    game.doors_open = 0;
+                    if (open && !rooms_trace(&game, a, b)) opened++;
+                    game.doors_open = SLOTS_ALL(DoorMask, LEVEL_DOOR_COUNT(&game.layout));
+                }
+            }
+        }
+        ok = ok && opened > 0;
+        printf("Saved with the doors open: %d sight lines opened up, all seen after a load\n", opened);
+#endif
+        
+        if (ok) {
+            printf("Only events wake enemies (Success)\n");
+        } else {
+            printf("Alerting wrong (Error)\n");
+            failures++;
+        }
+    }
+    
+#if RUNTIME_VIEWPORT
+    // Test 19: Viewports - a host build serves every size from VIEW_MIN to
+    // VIEW_MAX: GET_SCREEN answers at the current size, padded-stride
+    // frames hold the same rows, and the simulation ignores the size
+    {
+        static uint8_t big[VIEW_MAX_W * VIEW_MAX_H + 2];
+        uint8_t whole[4] = {CLA_DOOM, INS_GET_SCREEN, 0x00, 0x00};
+        uint8_t part[4] = {CLA_DOOM, INS_GET_SCREEN, 0x00, 0x07};
+        uint8_t more[5] = {0x00, INS_GET_RESPONSE, 0x00, 0x00, 0x00};
+        static const uint8_t sizes[][2] = {
+            {VIEW_MIN_W, VIEW_MIN_H}, {80, 30}, {133, 41}, {VIEW_MAX_W, VIEW_MAX_H}
+        };
+        uint32_t hashes[4];
+        bool ok = !set_viewport(VIEW_MIN_W - 1, VIEW_MIN_H) && !set_viewport(VIEW_MAX_W + 1, VIEW_MAX_H) &&
+                  !set_viewport(VIEW_MIN_W, VIEW_MAX_H + 1) && VIEW_W == SCREEN_W && VIEW_H == SCREEN_H;
+        
+        printf("\n=== Viewports ===\n");
+        for (int s = 0; s < 4; s++) {
+            int w = sizes[s][0], h = sizes[s][1];
+            Frame frame, spare, stale;
+            uint16_t got = 0;
+            
+            ok = ok && set_viewport(w, h) && frame_alloc(&frame);
+            if (!ok) break;
+            init_game_seeded(&game, 0x1234);
+            for (int t = 0; t < 40; t++) {
+                step_game(&game, "wwddsq  a"[t % 9]);
+                render_frame(&game, &frame);
+            }
+            hashes[s] = game_state_hash(&game);
+            
+            // Whole frame in one response, then in 7-row chunks
+            process_apdu(whole, 4, big, &resp_len);
+            ok = ok && resp_len == w * h + 2 && big[resp_len - 2] == 0x90;
+            for (int y = 0; ok && y < h; y++) {
+                ok = memcmp(&big[y * w], &FRAME_AT(&frame, 0, y), w) == 0;
+            }
+            process_apdu(part, 4, big, &resp_len);
+            while (ok && resp_len >= 2) {
+                int rows = (resp_len - 2) / w;
+                for (int y = 0; ok && y < rows; y++) {
+                    ok = memcmp(&big[y * w], &FRAME_AT(&frame, 0, got / w + y), w) == 0;
+                }
+                got += resp_len - 2;
+                if (big[resp_len - 2] != 0x61) break;
+                process_apdu(more, 5, big, &resp_len);
+            }
+            ok = ok && got == w * h && frame.stride % FRAME_ALIGN == 0 && frame.stride >= w;
+            
+            // Room for a back buffer (but no third frame at full size); a
+            // viewport change leaves old frames stale and undrawn
+            ok = ok && frame_alloc(&spare) && (w < VIEW_MAX_W || !frame_alloc(&stale));
+            stale = frame;
+            FRAME_AT(&stale, 0, 0) = 0;
+            set_viewport(w == VIEW_MAX_W ? VIEW_MIN_W : VIEW_MAX_W, h);
+            render_frame(&game, &stale);
+            ok = ok && FRAME_AT(&stale, 0, 0) == 0;
+            printf("%3dx%-2d  stride %3d  %5d bytes  hash %08X\n",
+                   w, h, frame.stride, got, (unsigned)hashes[s]);
+        }
+        ok = ok && hashes[1] == hashes[0] && hashes[2] == hashes[0] && hashes[3] == hashes[0];
+        set_viewport(SCREEN_W, SCREEN_H);
+        
+        if (ok) {
+            printf("Every viewport renders and plays the same game (Success)\n");
+        } else {
+            printf("Viewport wrong (Error)\n");
+            failures++;
+        }
+    }
+#endif
+
+#if LEVEL_COMPILED
+    // Test 20: Compiled levels - every blob decodes with its nav data
+    // intact: enemies stand in regions, doors join regions, and the
+    // precomputed sight lines agree with tracing them in the game. The
+    // walls decompress into exactly their own rows of the level arena,
+    // with no staging copy.
+    {
+        static GameState lv;
+        int bad = 0, bytes = 0, wall_bytes = 0, wall_raw = 0;
+        
+        printf("\n=== Compiled Level Data ===\n");
+        for (uint8_t level = 1; level <= LEVEL_COUNT; level++) {
+            const uint8_t* blob = level_blobs[level - 1];
+            int i;
+            
+            memset(&lv, 0, sizeof(lv));
+            lv.seed = GAME_DEFAULT_SEED;
+            begin_level(&lv, level);
+            level_build_step(&lv);
+            int rows = blob[LB_H] * LEVEL_ROW_BYTES(blob[LB_W]);
+            if (sim_arena_get_stats(ARENA_LEVEL)->used != rows + (rows & 1)) bad++;
+            while (!level_build_step(&lv)) {}
+            if (blob[0] != LEVEL_BLOB_MAGIC0 || blob[1] != LEVEL_BLOB_MAGIC1 ||
+                blob[LB_VERSION] != LEVEL_BLOB_VERSION) bad++;
+            
+            LevelBits walls = {level_blob_section(blob, LEVEL_BLOB_WALLS), 0};
+            static uint8_t row[LEVEL_WALL_RAM];
+            for (i = 0; i < blob[LB_H]; i++) {
+                level_decode_row(&walls, row + i * LEVEL_ROW_BYTES(blob[LB_W]), blob[LB_W]);
+            }
+            bytes += (int)(walls.src - blob) + ((walls.pos + 7) >> 3) + 1;
+            wall_bytes += ((walls.pos + 7) >> 3) + 1;
+            wall_raw += rows;
+            
+            FOR_EACH_LIVE(EnemyMask, lv.enemies.live, i) {
+                if (lv.layout.room_count && room_at(&lv, COORD_TILE(lv.enemies.x[i]), COORD_TILE(lv.enemies.y[i])) < 0) bad++;
+            }
+            for (i = 0; i < lv.layout.door_count; i++) {
+                RoomMask sides = rooms_at(&lv, lv.layout.doors[i].x, lv.layout.doors[i].y);
+                if (lv.layout.room_count && !sides) bad++;
+            }
+            for (int a = 0; a < lv.layout.room_count; a++) {
+                for (int b = a + 1; b < lv.layout.room_count; b++) {
+                    if (rooms_see(&lv, a, b) != rooms_trace(&lv, a, b)) bad++;
+                }
+            }
+        }
+        printf("%d levels in %d bytes (walls %d, %d as a bitmap), level descriptor %u bytes\n",
+               LEVEL_COUNT, bytes, wall_bytes, wall_raw, (unsigned)sizeof(LevelDesc));
+        
+        if (bad) {
+            printf("%d problems in the compiled levels (Error)\n", bad);
+            failures++;
+        } else {
+            printf("Nav and sight data match the maps (Success)\n");
+        }
+    }
+#endif
+    
+    if (failures) {
+        printf("\n=== %d Test(s) Failed ===\n", failures);
+        return 1;
+    }
+    
     printf("\n=== Test Complete ===\n");
     printf("The SIM application is working correctly!\n");
     printf("You can now deploy to real SIM hardware or use with swSIM.\n");
@@ -0,0 +1,579 @@
+/*
+ * Level Compiler - ASCII maps to compact level blobs
+ * Reads maps drawn with the game's own glyphs, checks them, precomputes
+ * the regions and sight lines the AI uses, and writes one blob per level
+ * plus level_blobs.c, which links them into a -DLEVEL_BLOBS build. Every
+ * blob is decoded by the game itself and compared tile by tile with its
+ * map before it is written. make levels runs it over the maps in levels/.
+ *
+ *   #  wall     D  door     X  exit     @  player
+ *   (space)     a  ammo     +  health   E  enemy
+ *
+ * Usage: level_compiler [-n] [-s] -o <dir> <map.txt>...
+ *   -n  no nav data (noise and sight cannot reach enemies, so they
+ *       start awake)
+ *   -s  no precomputed sight lines (traced as the game needs them)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+// The game decides tiles, limits and sight lines
+#include "../src/doom/text_doom_game.c"
+
+#ifndef LEVEL_BLOBS
+#error "Build the level compiler with -DLEVEL_BLOBS"
+#endif
+
+#define REGION_NONE     0xFF
+#define LEVEL_MAX_RECTS 255
+#define LEVEL_MAX_DOORS (LEVEL_MAX_ROOMS - 1)
+// Compressed walls at worst: every run a tile long, plus the pieces that
+// continue runs of 15 or more, and the pad byte
+#define WALL_BYTES(w, h) ((h) * (1 + 4 * ((w) + (w) / 15 + 1)) / 8 + 2)
+#define BLOB_MAX (LEVEL_BLOB_HEADER + WALL_BYTES(MAP_W, MAP_H) + 4 * LEVEL_MAX_DOORS + \
+                  3 * MAX_PICKUPS + 2 * MAX_ENEMIES + 5 * LEVEL_MAX_RECTS + 4 * LEVEL_MAX_ROOMS)
+
+// The game decodes the level being compiled as its level 1
+static uint8_t level_image[BLOB_MAX];
+const uint8_t* const level_blobs[] = {level_image};
+const uint8_t level_blob_count = 1;
+
+typedef struct {
+    const char* path;
+    int w, h;
+    char map[MAP_H][MAP_W + 1];
+    uint8_t region[MAP_H][MAP_W];           // REGION_NONE on walls and doors
+    int regions;
+    
+    uint8_t player[2], exit[2];
+    uint8_t doors[LEVEL_MAX_DOORS][2];
+    uint8_t joins[LEVEL_MAX_DOORS][2];      // Regions each door joins
+    uint8_t pickups[MAX_PICKUPS][3];
+    uint8_t spawns[MAX_ENEMIES][2];
+    uint8_t rects[LEVEL_MAX_RECTS][5];
+    uint8_t anchors[LEVEL_MAX_ROOMS][2];
+    uint16_t sight[LEVEL_MAX_ROOMS];
+    int door_count, pickup_count, spawn_count, rect_count;
+    
+    uint8_t blob[BLOB_MAX];
+    int size;
+    int walls_bytes, table_bytes, nav_bytes, sight_bytes;
+    int raw_walls;                          // The walls as a plain bitmap
+} Level;
+
+static bool with_nav = true;
+static bool with_sight = true;
+
+static bool fail(const Level* lv, int x, int y, const char* fmt, ...) {
+    va_list ap;
+    
+    if (y >= 0) fprintf(stderr, "%s:%d:%d: ", lv->path, y + 1, x + 1);
+    else fprintf(stderr, "%s: ", lv->path);
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+    return false;
+}
+
+// Tile the game must see at (x, y)
+static uint8_t glyph_tile(const Level* lv, int x, int y) {
+    if (x >= lv->w || y >= lv->h) return TILE_WALL;
+    switch (lv->map[y][x]) {
+        case CHAR_WALL:   return TILE_WALL;
+        case CHAR_EXIT:   return TILE_EXIT;
+        case CHAR_AMMO:   return TILE_AMMO;
+        case CHAR_HEALTH: return TILE_HEALTH;
+        case CHAR_DOOR:   return TILE_DOOR;
+        default:          return TILE_EMPTY;
+    }
+}
+
+static bool is_floor(const Level* lv, int x, int y) {
+    char c = lv->map[y][x];
+    return c != CHAR_WALL && c != CHAR_DOOR;
+}
+
+static bool read_map(Level* lv) {
+    FILE* f = fopen(lv->path, "r");
+    char line[512];
+    
+    if (!f) return fail(lv, 0, -1, "cannot open");
+    lv->w = lv->h = 0;
+    while (fgets(line, sizeof(line), f)) {
+        size_t n = strcspn(line, "\r\n");
+        line[n] = '\0';
+        if (n == 0) continue;               // Blank lines (such as a last one) are not rows
+        if (lv->h == MAP_H || n > MAP_W) {
+            fclose(f);
+            return fail(lv, 0, -1, "map is larger than the profile's %dx%d", MAP_W, MAP_H);
+        }
+        if (lv->h && (int)n != lv->w) {
+            fclose(f);
+            return fail(lv, (int)n, lv->h, "row is %d wide, the first is %d", (int)n, lv->w);
+        }
+        lv->w = (int)n;
+        memcpy(lv->map[lv->h++], line, n + 1);
+    }
+    fclose(f);
+    if (lv->w < 3 || lv->h < 3) return fail(lv, 0, -1, "map is smaller than 3x3");
+    return true;
+}
+
+// Glyphs, counts, border and doors
+static bool check_map(Level* lv) {
+    int players = 0, exits = 0;
+    
+    lv->door_count = lv->pickup_count = lv->spawn_count = 0;
+    for (int y = 0; y < lv->h; y++) {
+        for (int x = 0; x < lv->w; x++) {
+            char c = lv->map[y][x];
+            bool border = x == 0 || y == 0 || x == lv->w - 1 || y == lv->h - 1;
+            
+            if (border && c != CHAR_WALL) return fail(lv, x, y, "the map must be walled in");
+            switch (c) {
+                case CHAR_WALL: case CHAR_EMPTY:
+                    break;
+                case CHAR_PLAYER:
+                    lv->player[0] = (uint8_t)x;
+                    lv->player[1] = (uint8_t)y;
+                    players++;
+                    break;
+                case CHAR_EXIT:
+                    lv->exit[0] = (uint8_t)x;
+                    lv->exit[1] = (uint8_t)y;
+                    exits++;
+                    break;
+                case CHAR_AMMO: case CHAR_HEALTH:
+                    if (lv->pickup_count == MAX_PICKUPS) {
+                        return fail(lv, x, y, "more than %d pickups", MAX_PICKUPS);
+                    }
+                    lv->pickups[lv->pickup_count][0] = (uint8_t)x;
+                    lv->pickups[lv->pickup_count][1] = (uint8_t)y;
+                    lv->pickups[lv->pickup_count++][2] = c == CHAR_AMMO ? TILE_AMMO : TILE_HEALTH;
+                    break;
+                case CHAR_ENEMY:
+                    if (lv->spawn_count == MAX_ENEMIES) {
+                        return fail(lv, x, y, "more than %d enemies", MAX_ENEMIES);
+                    }
+                    lv->spawns[lv->spawn_count][0] = (uint8_t)x;
+                    lv->spawns[lv->spawn_count++][1] = (uint8_t)y;
+                    break;
+                case CHAR_DOOR: {
+                    // A door sits in a wall, with floor on either side
+                    bool across = lv->map[y][x - 1] == CHAR_WALL && lv->map[y][x + 1] == CHAR_WALL &&
+                                  is_floor(lv, x, y - 1) && is_floor(lv, x, y + 1);
+                    bool along = lv->map[y - 1][x] == CHAR_WALL && lv->map[y + 1][x] == CHAR_WALL &&
+                                 is_floor(lv, x - 1, y) && is_floor(lv, x + 1, y);
+                    if (!across && !along) {
+                        return fail(lv, x, y, "a door needs wall on two opposite sides and floor on the others");
+                    }
+                    if (lv->door_count == LEVEL_MAX_DOORS) {
+                        return fail(lv, x, y, "more than %d doors", LEVEL_MAX_DOORS);
+                    }
+                    lv->doors[lv->door_count][0] = (uint8_t)x;
+                    lv->doors[lv->door_count++][1] = (uint8_t)y;
+                    break;
+                }
+                default:
+                    return fail(lv, x, y, "unknown glyph '%c'", c);
+            }
+        }
+    }
+    if (players != 1) return fail(lv, 0, -1, "needs exactly one player start (%d found)", players);
+    if (exits != 1) return fail(lv, 0, -1, "needs exactly one exit (%d found)", exits);
+    return true;
+}
+
+// Flood-fill tiles from (x, y) through floor (and doors, if 'doors'),
+// marking them with 'id' in 'mark'
+static void flood(const Level* lv, uint8_t mark[MAP_H][MAP_W], int x, int y, uint8_t id, bool doors) {
+    static uint16_t queue[MAP_W * MAP_H];
+    int head = 0, tail = 0;
+    
+    mark[y][x] = id;
+    queue[tail++] = (uint16_t)(y * MAP_W + x);
+    while (head < tail) {
+        x = queue[head] % MAP_W;
+        y = queue[head++] / MAP_W;
+        const int step[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+        for (int d = 0; d < 4; d++) {
+            int nx = x + step[d][0], ny = y + step[d][1];
+            char c = lv->map[ny][nx];
+            if (mark[ny][nx] != REGION_NONE || c == CHAR_WALL || (c == CHAR_DOOR && !doors)) continue;
+            mark[ny][nx] = id;
+            queue[tail++] = (uint16_t)(ny * MAP_W + nx);
+        }
+    }
+}
+
+// Everything the player needs must be reachable, opening doors on the way
+static bool check_reachable(const Level* lv) {
+    static uint8_t reach[MAP_H][MAP_W];
+    
+    memset(reach, REGION_NONE, sizeof(reach));
+    flood(lv, reach, lv->player[0], lv->player[1], 0, true);
+    if (reach[lv->exit[1]][lv->exit[0]]) return fail(lv, lv->exit[0], lv->exit[1], "exit is unreachable");
+    for (int i = 0; i < lv->pickup_count; i++) {
+        if (reach[lv->pickups[i][1]][lv->pickups[i][0]]) {
+            return fail(lv, lv->pickups[i][0], lv->pickups[i][1], "pickup is unreachable");
+        }
+    }
+    return true;
+}
+
+// Regions: the floor between doors
+static bool find_regions(Level* lv) {
+    memset(lv->region, REGION_NONE, sizeof(lv->region));
+    lv->regions = 0;
+    for (int y = 1; y < lv->h - 1; y++) {
+        for (int x = 1; x < lv->w - 1; x++) {
+            if (lv->region[y][x] != REGION_NONE || !is_floor(lv, x, y)) continue;
+            if (lv->regions == LEVEL_MAX_ROOMS) {
+                return fail(lv, x, y, "more than %d regions between doors (compile with -n to skip nav data)",
+                            LEVEL_MAX_ROOMS);
+            }
+            flood(lv, lv->region, x, y, (uint8_t)lv->regions++, false);
+        }
+    }
+    for (int i = 0; i < lv->door_count; i++) {
+        int x = lv->doors[i][0], y = lv->doors[i][1];
+        bool across = lv->map[y][x - 1] == CHAR_WALL;
+        lv->joins[i][0] = across ? lv->region[y - 1][x] : lv->region[y][x - 1];
+        lv->joins[i][1] = across ? lv->region[y + 1][x] : lv->region[y][x + 1];
+    }
+    return true;
+}
+
+// Cover each region with rects that may run over walls and doors (which
+// room_at() is never asked about) but never over another region's floor.
+// Each rect is the one from the first uncovered tile that covers the most.
+static bool cover_regions(Level* lv) {
+    static uint8_t covered[MAP_H][MAP_W];
+    
+    memset(covered, 0, sizeof(covered));
+    lv->rect_count = 0;
+    for (int r = 0; r < lv->regions; r++) {
+        for (int y = 0; y < lv->h; y++) {
+            for (int x = 0; x < lv->w; x++) {
+                if (lv->region[y][x] != r || covered[y][x]) continue;
+                
+                int best_w = 1, best_h = 1, best = 0, x1, y1, i;
+                for (x1 = x; x1 < lv->w; x1++) {
+                    uint8_t g = lv->region[y][x1];
+                    if (g != r && g != REGION_NONE) break;
+                    for (y1 = y + 1; y1 < lv->h; y1++) {
+                        for (i = x; i <= x1; i++) {
+                            if (lv->region[y1][i] != r && lv->region[y1][i] != REGION_NONE) break;
+                        }
+                        if (i <= x1) break;
+                    }
+                    int gain = 0;
+                    for (int ty = y; ty < y1; ty++) {
+                        for (i = x; i <= x1; i++) gain += lv->region[ty][i] == r && !covered[ty][i];
+                    }
+                    if (gain > best) {
+                        best = gain;
+                        best_w = x1 - x + 1;
+                        best_h = y1 - y;
+                    }
+                }
+                
+                if (lv->rect_count == LEVEL_MAX_RECTS) {
+                    return fail(lv, x, y, "regions need more than %d rects", LEVEL_MAX_RECTS);
+                }
+                uint8_t* rect = lv->rects[lv->rect_count++];
+                rect[0] = (uint8_t)x;
+                rect[1] = (uint8_t)y;
+                rect[2] = (uint8_t)best_w;
+                rect[3] = (uint8_t)best_h;
+                rect[4] = (uint8_t)r;
+                for (int ty = y; ty < y + best_h; ty++) {
+                    for (i = x; i < x + best_w; i++) covered[ty][i] |= lv->region[ty][i] == r;
+                }
+            }
+        }
+    }
+    
+    // Anchors: the region's tile nearest its centroid
+    for (int r = 0; r < lv->regions; r++) {
+        long sx = 0, sy = 0, n = 0, best = -1;
+        int x, y;
+        for (y = 0; y < lv->h; y++) {
+            for (x = 0; x < lv->w; x++) {
+                if (lv->region[y][x] == r) { sx += x; sy += y; n++; }
+            }
+        }
+        for (y = 0; y < lv->h; y++) {
+            for (x = 0; x < lv->w; x++) {
+                if (lv->region[y][x] != r) continue;
+                long d = (x * n - sx) * (x * n - sx) + (y * n - sy) * (y * n - sy);
+                if (best < 0 || d < best) {
+                    best = d;
+                    lv->anchors[r][0] = (uint8_t)x;
+                    lv->anchors[r][1] = (uint8_t)y;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static int put_pairs(uint8_t* out, const uint8_t (*pairs)[2], int n) {
+    for (int i = 0; i < n; i++) {
+        out[2 * i] = pairs[i][0];
+        out[2 * i + 1] = pairs[i][1];
+    }
+    return 2 * n;
+}
+
+// Writer for the compressed walls, most significant bit first
+typedef struct {
+    uint8_t* dst;
+    int pos;
+} BitWriter;
+
+static void put_bits(BitWriter* out, int v, int n) {
+    while (n-- > 0) {
+        if ((v >> n) & 1) out->dst[out->pos >> 3] |= (uint8_t)(0x80 >> (out->pos & 7));
+        out->pos++;
+    }
+}
+
+// A run length in 4-bit pieces (see level_decode_row)
+static void put_run(BitWriter* out, int run) {
+    for (; run >= 15; run -= 15) put_bits(out, 15, 4);
+    put_bits(out, run, 4);
+}
+
+static bool same_walls(const Level* lv, int y0, int y1) {
+    for (int x = 0; x < lv->w; x++) {
+        if ((lv->map[y0][x] == CHAR_WALL) != (lv->map[y1][x] == CHAR_WALL)) return false;
+    }
+    return true;
+}
+
+// Compress row y of the walls: a repeat of the row above, or its runs
+static void put_row(BitWriter* out, const Level* lv, int y) {
+    const char* row = lv->map[y];
+    
+    if (y > 0 && same_walls(lv, y, y - 1)) {
+        put_bits(out, 0, 1);
+        return;
+    }
+    put_bits(out, 1, 1);
+    for (int x = 0, wall = 1; x < lv->w; wall = !wall) {
+        int run = 0;
+        while (x < lv->w && (row[x] == CHAR_WALL) == wall) {
+            run++;
+            x++;
+        }
+        put_run(out, run);
+    }
+}
+
+// Lay the blob out (see the format in text_doom_game.c)
+static void encode(Level* lv, bool sight) {
+    uint8_t* b = lv->blob;
+    int regions = with_nav ? lv->regions : 0;
+    int at, i;
+    
+    memset(b, 0, sizeof(lv->blob));
+    b[0] = LEVEL_BLOB_MAGIC0;
+    b[1] = LEVEL_BLOB_MAGIC1;
+    b[LB_VERSION] = LEVEL_BLOB_VERSION;
+    b[LB_FLAGS] = (uint8_t)((with_nav ? LEVEL_BLOB_NAV : 0) | (sight ? LEVEL_BLOB_SIGHT : 0));
+    b[LB_W] = (uint8_t)lv->w;
+    b[LB_H] = (uint8_t)lv->h;
+    b[LB_PLAYER] = lv->player[0];
+    b[LB_PLAYER + 1] = lv->player[1];
+    b[LB_EXIT] = lv->exit[0];
+    b[LB_EXIT + 1] = lv->exit[1];
+    b[LB_DOORS] = (uint8_t)lv->door_count;
+    b[LB_PICKUPS] = (uint8_t)lv->pickup_count;
+    b[LB_SPAWNS] = (uint8_t)lv->spawn_count;
+    b[LB_REGIONS] = (uint8_t)regions;
+    b[LB_RECTS] = (uint8_t)(with_nav ? lv->rect_count : 0);
+    
+    at = LEVEL_BLOB_HEADER;
+    at += put_pairs(b + at, (const uint8_t (*)[2])lv->doors, lv->door_count);
+    for (i = 0; i < lv->pickup_count; i++, at += 3) memcpy(b + at, lv->pickups[i], 3);
+    at += put_pairs(b + at, (const uint8_t (*)[2])lv->spawns, lv->spawn_count);
+    lv->table_bytes = at - LEVEL_BLOB_HEADER;
+    
+    if (with_nav) {
+        for (i = 0; i < lv->rect_count; i++, at += 5) memcpy(b + at, lv->rects[i], 5);
+        at += put_pairs(b + at, (const uint8_t (*)[2])lv->joins, lv->door_count);
+        at += put_pairs(b + at, (const uint8_t (*)[2])lv->anchors, regions);
+    }
+    lv->nav_bytes = at - LEVEL_BLOB_HEADER - lv->table_bytes;
+    
+    if (sight) {
+        for (i = 0; i < regions; i++, at += 2) {
+            b[at] = (uint8_t)(lv->sight[i] >> 8);
+            b[at + 1] = (uint8_t)lv->sight[i];
+        }
+    }
+    lv->sight_bytes = 2 * (sight ? regions : 0);
+    
+    BitWriter walls = {b + at, 0};
+    for (int y = 0; y < lv->h; y++) put_row(&walls, lv, y);
+    lv->walls_bytes = (walls.pos + 7) / 8 + 1;
+    lv->raw_walls = lv->h * LEVEL_ROW_BYTES(lv->w);
+    lv->size = at + lv->walls_bytes;
+}
+
+// Decode the blob with the game, as a fresh level 1
+static void load(const Level* lv, GameState* game) {
+    memcpy(level_image, lv->blob, (size_t)lv->size);
+    memset(game, 0, sizeof(*game));
+    game->seed = game->rng = GAME_DEFAULT_SEED;
+    game->health = 100;
+    init_level(game, 1);
+}
+
+// The game must see exactly the map that was drawn
+static bool verify(const Level* lv, GameState* game) {
+    const EnemyPool* e = &game->enemies;
+    int i;
+    
+    load(lv, game);
+    for (int y = 0; y < MAP_H; y++) {
+        for (int x = 0; x < MAP_W; x++) {
+            if (map_tile(game, x, y) != glyph_tile(lv, x, y)) {
+                return fail(lv, x, y, "decodes as tile %d", map_tile(game, x, y));
+            }
+            if (with_nav && x < lv->w && y < lv->h && lv->region[y][x] != REGION_NONE &&
+                room_at(game, x, y) != lv->region[y][x]) {
+                return fail(lv, x, y, "decodes in region %d, not %d", room_at(game, x, y), lv->region[y][x]);
+            }
+        }
+    }
+    if (COORD_TILE(game->player_x) != lv->player[0] || COORD_TILE(game->player_y) != lv->player[1]) {
+        return fail(lv, lv->player[0], lv->player[1], "player starts elsewhere");
+    }
+    for (i = 0; i < lv->spawn_count && i < ENEMY_CAP(game); i++) {
+        if (!(e->live & SLOT_BIT(EnemyMask, i)) || COORD_TILE(e->x[i]) != lv->spawns[i][0] ||
+            COORD_TILE(e->y[i]) != lv->spawns[i][1]) {
+            return fail(lv, lv->spawns[i][0], lv->spawns[i][1], "enemy %d spawns elsewhere", i);
+        }
+    }
+    return true;
+}
+
+static bool compile(Level* lv) {
+    static GameState game;
+    
+    if (!read_map(lv) || !check_map(lv) || !check_reachable(lv)) return false;
+    if (with_nav && (!find_regions(lv) || !cover_regions(lv))) return false;
+    
+    // Sight lines with every door shut, traced by the game on the level
+    // without them
+    encode(lv, false);
+    if (with_nav && with_sight) {
+        load(lv, &game);
+        memset(lv->sight, 0, sizeof(lv->sight));
+        for (int a = 0; a < lv->regions; a++) {
+            for (int b = a + 1; b < lv->regions; b++) {
+                if (rooms_trace(&game, a, b)) lv->sight[a] |= (uint16_t)(1u << b);
+            }
+        }
+        encode(lv, true);
+    }
+    return verify(lv, &game);
+}
+
+// Blob symbol for 'path': its file name, less the extension
+static void level_name(const char* path, char* out, size_t size) {
+    const char* base = strrchr(path, '/');
+    size_t n = 0;
+    
+    for (base = base ? base + 1 : path; *base && *base != '.' && n + 1 < size; base++) {
+        char c = *base;
+        out[n++] = ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) ? c : '_';
+    }
+    out[n] = '\0';
+}
+
+int main(int argc, char** argv) {
+    static Level levels[255];
+    const char* dir = NULL;
+    char name[64], path[512];
+    int count = 0, errors = 0, total = 0, walls = 0, raw = 0, i;
+    
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0) with_nav = false;
+        else if (strcmp(argv[i], "-s") == 0) with_sight = false;
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) dir = argv[++i];
+        else if (argv[i][0] == '-' || count == 255) break;
+        else levels[count++].path = argv[i];
+    }
+    if (!dir || i < argc || count == 0) {
+        fprintf(stderr, "Usage: %s [-n] [-s] -o <dir> <map.txt>...\n", argv[0]);
+        return 2;
+    }
+    
+    for (i = 0; i < count; i++) {
+        if (!compile(&levels[i])) errors++;
+    }
+    if (errors) {
+        fprintf(stderr, "%d of %d levels failed\n", errors, count);
+        return 1;
+    }
+    
+    // One blob file per level, and the C table that links them all
+    snprintf(path, sizeof(path), "%s/level_blobs.c", dir);
+    FILE* src = fopen(path, "w");
+    if (!src) {
+        fprintf(stderr, "%s: cannot write\n", path);
+        return 1;
+    }
+    fprintf(src, "/* Generated by tools/level_compiler.c - do not edit */\n\n#include <stdint.h>\n");
+    
+    printf("Compiled levels for a %dx%d map (%s)\n", MAP_W, MAP_H, MEMORY_SIZE_STR);
+    printf("%-10s %5s %5s %7s %7s %7s %5s | %9s %6s %5s %5s %6s\n", "level", "map", "doors",
+           "pickups", "enemies", "regions", "rects", "walls/raw", "tables", "nav", "sight", "bytes");
+    for (i = 0; i < count; i++) {
+        const Level* lv = &levels[i];
+        
+        level_name(lv->path, name, sizeof(name));
+        snprintf(path, sizeof(path), "%s/%s.lvl", dir, name);
+        FILE* f = fopen(path, "wb");
+        if (!f || fwrite(lv->blob, 1, (size_t)lv->size, f) != (size_t)lv->size) {
+            fprintf(stderr, "%s: cannot write\n", path);
+            return 1;
+        }
+        fclose(f);
+        
+        fprintf(src, "\n// %s\nstatic const uint8_t level_%s[%d] = {", lv->path, name, lv->size);
+        for (int k = 0; k < lv->size; k++) {
+            fprintf(src, "%s0x%02X%s", k % 12 ? " " : "\n    ", lv->blob[k], k + 1 < lv->size ? "," : "");
+        }
+        fprintf(src, "\n};\n");
+        
+        printf("%-10s %2dx%-2d %5d %7d %7d %7d %5d | %4d/%-4d %6d %5d %5d %6d\n", name, lv->w, lv->h,
+               lv->door_count, lv->pickup_count, lv->spawn_count, with_nav ? lv->regions : 0,
+               with_nav ? lv->rect_count : 0, lv->walls_bytes, lv->raw_walls,
+               LEVEL_BLOB_HEADER + lv->table_bytes, lv->nav_bytes, lv->sight_bytes, lv->size);
+        total += lv->size;
+        walls += lv->walls_bytes;
+        raw += lv->raw_walls;
+    }
+
+    fprintf(src, "\nconst uint8_t* const level_blobs[] = {");
+    for (i = 0; i < count; i++) {
+        level_name(levels[i].path, name, sizeof(name));
+        fprintf(src, "%slevel_%s", i ? ", " : "", name);
+    }
+    fprintf(src, "};\nconst uint8_t level_blob_count = %d;\n", count);
+    fclose(src);
+
+    printf("%d levels, %d bytes of ROM (%d a level); walls %d bytes, %d%% of a plain bitmap\n",
+           count, total, total / count, walls, 100 * walls / raw);
+    printf("A byte-per-tile %dx%d map (%d bytes) holds %d levels like these\n",
+           MAP_W, MAP_H, MAP_W * MAP_H, MAP_W * MAP_H * count / total);
+    return 0;
+}
@@ -0,0 +1,67 @@
+/*
+ * RAD PVS Compiler - bakes RAD-Doom's visibility sets offline
+ * The RAD map is the same every game, so its potentially visible sets
+ * need tracing only once, not each time a card generates the map. This
+ * generates the map with the engine itself, traces the sets and writes
+ * them as a constant table for a -DRAD_PVS_BAKED build. make rad-pvs runs
+ * it; rerun it whenever the map or the cluster size changes.
+ *
+ * Usage: rad_pvs_compiler <out.h>
+ */
+
+#include <stdio.h>
+
+// The engine decides the map, the clusters and the sets
+#include "../src/doom/rad_doom_enhanced.c"
+
+#ifdef RAD_PVS_BAKED
+#error "Build the PVS compiler without -DRAD_PVS_BAKED"
+#endif
+
+static GameState game;
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <out.h>\n", argv[0]);
+        return 1;
+    }
+    
+    init_rad_game(&game);
+    
+    FILE* f = fopen(argv[1], "w");
+    if (!f) {
+        perror(argv[1]);
+        return 1;
+    }
+    fprintf(f, "// Generated by tools/rad_pvs_compiler.c (make rad-pvs); do not edit\n");
+    fprintf(f, "#if MAP_W != %d || MAP_H != %d || RAD_CLUSTER_SHIFT != %d\n",
+            MAP_W, MAP_H, RAD_CLUSTER_SHIFT);
+    fprintf(f, "#error \"rad_pvs.h was baked for another map size: rerun make rad-pvs\"\n");
+    fprintf(f, "#endif\n\n");
+    fprintf(f, "static const uint8_t rad_pvs[RAD_CLUSTERS][RAD_PVS_BYTES] = {\n");
+    
+    int sets = 0, clusters = 0;
+    for (int c = 0; c < RAD_CLUSTERS; c++) {
+        int size = 0;
+        fprintf(f, "    {");
+        for (int b = 0; b < RAD_PVS_BYTES; b++) {
+            fprintf(f, "%s0x%02X", b ? ", " : "", game.pvs[c][b]);
+        }
+        fprintf(f, "},\n");
+        for (int d = 0; d < RAD_CLUSTERS; d++) size += RAD_PVS_HAS(game.pvs[c], d);
+        if (size) {
+            sets++;
+            clusters += size;
+        }
+    }
+    fprintf(f, "};\n");
+    if (fclose(f) != 0) {
+        perror(argv[1]);
+        return 1;
+    }
+    
+    printf("%s: %d clusters of %dx%d tiles, %u bytes, %.1f clusters per set\n",
+           argv[1], RAD_CLUSTERS, RAD_CLUSTER, RAD_CLUSTER, (unsigned)sizeof(game.pvs),
+           sets ? (double)clusters / sets : 0.0);
+    return 0;
+}